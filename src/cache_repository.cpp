@@ -0,0 +1,112 @@
+#include "cache_repository.h"
+
+UsuarioRepositoryCache::UsuarioRepositoryCache(std::shared_ptr<IUsuarioRepository> repo) : origem(std::move(repo)) {}
+
+void UsuarioRepositoryCache::guardar(const Usuario& user, uint64_t geracaoDaCarga) {
+    // Chamado com m travado em modo exclusivo
+    if (geracaoDaCarga != geracao) return;
+    porLogin[user.login] = user.id;
+    porId[user.id] = user;
+}
+
+void UsuarioRepositoryCache::invalidar(int userId) {
+    std::unique_lock<std::shared_mutex> lock(m);
+    auto it = porId.find(userId);
+    if (it != porId.end()) {
+        porLogin.erase(it->second.login);
+        porId.erase(it);
+    }
+    todos.reset();
+    geracao++;
+    invalidacoes.fetch_add(1, std::memory_order_relaxed);
+}
+
+Usuario UsuarioRepositoryCache::salvar(const Usuario& user) {
+    Usuario salvo = origem->salvar(user);
+    invalidar(salvo.id);
+    return salvo;
+}
+
+std::optional<Usuario> UsuarioRepositoryCache::buscarPorLogin(const std::string& login) {
+    uint64_t geracaoDaCarga;
+    {
+        std::shared_lock<std::shared_mutex> lock(m);
+        auto it = porLogin.find(login);
+        if (it != porLogin.end()) {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return porId.at(it->second);
+        }
+        geracaoDaCarga = geracao;
+    }
+    misses.fetch_add(1, std::memory_order_relaxed);
+    auto user = origem->buscarPorLogin(login);
+    if (user) {
+        std::unique_lock<std::shared_mutex> lock(m);
+        guardar(*user, geracaoDaCarga);
+    }
+    return user;
+}
+
+std::optional<Usuario> UsuarioRepositoryCache::buscarPorId(int id) {
+    uint64_t geracaoDaCarga;
+    {
+        std::shared_lock<std::shared_mutex> lock(m);
+        auto it = porId.find(id);
+        if (it != porId.end()) {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second;
+        }
+        geracaoDaCarga = geracao;
+    }
+    misses.fetch_add(1, std::memory_order_relaxed);
+    auto user = origem->buscarPorId(id);
+    if (user) {
+        std::unique_lock<std::shared_mutex> lock(m);
+        guardar(*user, geracaoDaCarga);
+    }
+    return user;
+}
+
+void UsuarioRepositoryCache::deletar(int id) {
+    origem->deletar(id);
+    invalidar(id);
+}
+
+void UsuarioRepositoryCache::vincularHidrometro(int userId, const std::string& idSHA) {
+    origem->vincularHidrometro(userId, idSHA);
+    invalidar(userId);
+}
+
+void UsuarioRepositoryCache::desvincularHidrometro(int userId, const std::string& idSHA) {
+    origem->desvincularHidrometro(userId, idSHA);
+    invalidar(userId);
+}
+
+std::vector<Usuario> UsuarioRepositoryCache::listarTodosUsuarios() {
+    uint64_t geracaoDaCarga;
+    {
+        std::shared_lock<std::shared_mutex> lock(m);
+        if (todos) {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return *todos;
+        }
+        geracaoDaCarga = geracao;
+    }
+    misses.fetch_add(1, std::memory_order_relaxed);
+    auto usuarios = std::make_shared<const std::vector<Usuario>>(origem->listarTodosUsuarios());
+
+    std::unique_lock<std::shared_mutex> lock(m);
+    if (geracaoDaCarga == geracao) {
+        todos = usuarios;
+        for (const auto& u : *usuarios) guardar(u, geracaoDaCarga);
+    }
+    return *usuarios;
+}
+
+EstatisticasCache UsuarioRepositoryCache::estatisticas() const {
+    EstatisticasCache est;
+    est.hits = hits.load(std::memory_order_relaxed);
+    est.misses = misses.load(std::memory_order_relaxed);
+    est.invalidacoes = invalidacoes.load(std::memory_order_relaxed);
+    return est;
+}
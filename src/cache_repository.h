@@ -0,0 +1,55 @@
+#ifndef CACHE_REPOSITORY_H
+#define CACHE_REPOSITORY_H
+
+#include "core.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+struct EstatisticasCache {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t invalidacoes = 0;
+};
+
+// Decorator read-through sobre IUsuarioRepository: buscarPorId/buscarPorLogin/
+// listarTodosUsuarios são servidos da memória e qualquer escrita invalida as
+// entradas afetadas antes de retornar.
+class UsuarioRepositoryCache : public IUsuarioRepository {
+private:
+    std::shared_ptr<IUsuarioRepository> origem;
+
+    std::unordered_map<int, Usuario> porId;
+    std::unordered_map<std::string, int> porLogin;
+    std::shared_ptr<const std::vector<Usuario>> todos; // snapshot de listarTodosUsuarios
+    // Incrementada a cada invalidação; cargas iniciadas antes dela são descartadas
+    uint64_t geracao = 0;
+    mutable std::shared_mutex m;
+
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> invalidacoes{0};
+
+    void guardar(const Usuario& user, uint64_t geracaoDaCarga);
+    void invalidar(int userId);
+
+public:
+    explicit UsuarioRepositoryCache(std::shared_ptr<IUsuarioRepository> repo);
+
+    Usuario salvar(const Usuario& user) override;
+    std::optional<Usuario> buscarPorLogin(const std::string& login) override;
+    std::optional<Usuario> buscarPorId(int id) override;
+    void deletar(int id) override;
+    void vincularHidrometro(int userId, const std::string& idSHA) override;
+    void desvincularHidrometro(int userId, const std::string& idSHA) override;
+    std::vector<Usuario> listarTodosUsuarios() override;
+
+    EstatisticasCache estatisticas() const;
+};
+
+#endif // CACHE_REPOSITORY_H
@@ -0,0 +1,73 @@
+#include "cooldown_alertas.h"
+#include <cmath>
+#include <algorithm>
+
+TabelaCooldown::TabelaCooldown(PoliticaAlerta politica)
+    : politicaAtual(std::make_shared<const PoliticaAlerta>(politica)) {}
+
+void TabelaCooldown::definirPolitica(const PoliticaAlerta& politica) {
+    std::atomic_store(&politicaAtual, std::make_shared<const PoliticaAlerta>(politica));
+}
+
+DecisaoAlerta TabelaCooldown::avaliar(int userId, int regraId, double consumo, Relogio::time_point agora) {
+    auto pol = std::atomic_load(&politicaAtual);
+    Shard& shard = shards[indiceShard(userId)];
+
+    DecisaoAlerta decisao = DecisaoAlerta::ENVIAR;
+    {
+        std::lock_guard<std::mutex> lock(shard.m);
+        auto [it, novo] = shard.estados.try_emplace(Chave{userId, regraId});
+        Estado& e = it->second;
+        if (!novo) {
+            auto desde = agora - e.ultimoEnvio;
+            double escala = std::max(std::fabs(e.ultimoConsumo), 1e-9);
+            if (desde < pol->cooldown) {
+                decisao = DecisaoAlerta::SUPRIMIR_COOLDOWN;
+            } else if (desde < pol->janelaDedup && std::fabs(consumo - e.ultimoConsumo) <= pol->toleranciaDedup * escala) {
+                decisao = DecisaoAlerta::SUPRIMIR_DUPLICADO;
+            }
+            // Condição persistente: depois de N supressões seguidas o alerta sai mesmo assim
+            if (decisao != DecisaoAlerta::ENVIAR && pol->suprimidosParaEscalar > 0 &&
+                e.suprimidos + 1 >= pol->suprimidosParaEscalar) {
+                decisao = DecisaoAlerta::ESCALAR;
+            }
+        }
+        if (decisao == DecisaoAlerta::ENVIAR || decisao == DecisaoAlerta::ESCALAR) {
+            e.ultimoEnvio = agora;
+            e.ultimoConsumo = consumo;
+            e.suprimidos = 0;
+        } else {
+            e.suprimidos++;
+        }
+    }
+
+    switch (decisao) {
+        case DecisaoAlerta::ENVIAR: enviados++; break;
+        case DecisaoAlerta::ESCALAR: escalados++; break;
+        case DecisaoAlerta::SUPRIMIR_COOLDOWN: suprimidosCooldown++; break;
+        case DecisaoAlerta::SUPRIMIR_DUPLICADO: suprimidosDuplicados++; break;
+    }
+    return decisao;
+}
+
+void TabelaCooldown::esquecer(int userId) {
+    Shard& shard = shards[indiceShard(userId)];
+    std::lock_guard<std::mutex> lock(shard.m);
+    for (auto it = shard.estados.begin(); it != shard.estados.end();) {
+        if (it->first.userId == userId) it = shard.estados.erase(it);
+        else ++it;
+    }
+}
+
+size_t TabelaCooldown::tamanho() const {
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.m);
+        total += shard.estados.size();
+    }
+    return total;
+}
+
+TabelaCooldown::Estatisticas TabelaCooldown::estatisticas() const {
+    return {enviados.load(), escalados.load(), suprimidosCooldown.load(), suprimidosDuplicados.load()};
+}
@@ -0,0 +1,89 @@
+#ifndef COOLDOWN_ALERTAS_H
+#define COOLDOWN_ALERTAS_H
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Política de repetição de um alerta (mesmo usuário, mesma regra)
+struct PoliticaAlerta {
+    std::chrono::seconds cooldown{120};    // intervalo mínimo entre envios
+    std::chrono::seconds janelaDedup{0};   // após o cooldown, repetição com o mesmo consumo ainda é suprimida (0 = desliga)
+    double toleranciaDedup = 0.05;         // variação relativa de consumo tratada como "mesmo consumo"
+    int suprimidosParaEscalar = 0;         // disparos suprimidos seguidos até enviar mesmo assim (0 = desliga)
+};
+
+enum class DecisaoAlerta { ENVIAR, ESCALAR, SUPRIMIR_COOLDOWN, SUPRIMIR_DUPLICADO };
+
+// Tabela de cooldown por (usuário, id persistido da regra) dividida em shards, cada um com sua
+// trava e seu mapa: verificações de usuários diferentes raramente disputam a
+// mesma trava e nenhuma trava é mantida fora de avaliar(). A política é um
+// snapshot imutável trocado atomicamente.
+class TabelaCooldown {
+public:
+    using Relogio = std::chrono::steady_clock;
+
+    struct Estatisticas {
+        uint64_t enviados = 0;
+        uint64_t escalados = 0;
+        uint64_t suprimidosCooldown = 0;
+        uint64_t suprimidosDuplicados = 0;
+    };
+
+    explicit TabelaCooldown(PoliticaAlerta politica = PoliticaAlerta{});
+
+    void definirPolitica(const PoliticaAlerta& politica);
+    PoliticaAlerta politica() const { return *std::atomic_load(&politicaAtual); }
+
+    // Decide e já registra o envio quando a decisão é ENVIAR ou ESCALAR
+    DecisaoAlerta avaliar(int userId, int regraId, double consumo, Relogio::time_point agora = Relogio::now());
+    // Esquece o estado de um usuário (ex: usuário removido)
+    void esquecer(int userId);
+
+    size_t tamanho() const;
+    Estatisticas estatisticas() const;
+
+private:
+    static constexpr size_t NUM_SHARDS = 64;
+
+    struct Chave {
+        int userId;
+        int regraId;
+        bool operator==(const Chave& o) const { return userId == o.userId && regraId == o.regraId; }
+    };
+    struct HashChave {
+        size_t operator()(const Chave& c) const {
+            uint64_t h = static_cast<uint64_t>(static_cast<uint32_t>(c.userId)) * 0x9E3779B97F4A7C15ull;
+            return static_cast<size_t>(h ^ static_cast<uint32_t>(c.regraId));
+        }
+    };
+    struct Estado {
+        Relogio::time_point ultimoEnvio;
+        double ultimoConsumo = 0.0;
+        int suprimidos = 0;
+    };
+    // Um shard por linha de cache para as travas não se atrapalharem
+    struct alignas(64) Shard {
+        mutable std::mutex m;
+        std::unordered_map<Chave, Estado, HashChave> estados;
+    };
+
+    std::array<Shard, NUM_SHARDS> shards;
+    std::shared_ptr<const PoliticaAlerta> politicaAtual;
+
+    std::atomic<uint64_t> enviados{0};
+    std::atomic<uint64_t> escalados{0};
+    std::atomic<uint64_t> suprimidosCooldown{0};
+    std::atomic<uint64_t> suprimidosDuplicados{0};
+
+    // O shard depende só do usuário, assim esquecer() olha um shard só
+    static size_t indiceShard(int userId) {
+        return static_cast<size_t>((static_cast<uint32_t>(userId) * 2654435761u) >> 26) % NUM_SHARDS;
+    }
+};
+
+#endif // COOLDOWN_ALERTAS_H
@@ -7,6 +7,11 @@
 #include <optional>
 #include <chrono>
 #include <variant>
+#include <cstdint>
+#include <ctime>
+#include <limits>
+#include <functional>
+#include <string_view>
 
 // ==================== ENUMS ====================
 enum class Perfil { ADMIN, LEITOR };
@@ -31,7 +36,7 @@ struct Leitura {
     int id = 0;
     int userId = 0;
     std::string idSHA;
-    std::string data; // ISO8601 com millisegundos
+    int64_t data = 0; // ms desde a epoch (UTC)
     double valor = 0.0;
     std::string caminhoImagem;
 };
@@ -41,7 +46,7 @@ struct AlertaRecord {
     int userId = 0;
     double consumo = 0.0;
     std::string mensagem;
-    std::string data; // ISO8601
+    int64_t data = 0; // ms desde a epoch (UTC)
 };
 
 struct DadosAlerta {
@@ -49,9 +54,73 @@ struct DadosAlerta {
     std::string nomeUser;
     double consumo = 0.0;
     std::string mensagem;
-    std::string data;
+    int64_t data = 0; // ms desde a epoch (UTC)
 };
 
+// Consulta paginada de histórico: intervalo [inicio, fim) em ms e paginação por
+// keyset (data, id) decrescente, para percorrer anos de dados com memória
+// constante e começar direto no intervalo pedido, sem passar pelas linhas mais novas.
+struct FiltroHistorico {
+    int userId = 0;
+    int64_t inicio = 0;
+    int64_t fim = std::numeric_limits<int64_t>::max();
+    std::optional<std::string> idSHA; // só se aplica a leituras
+    int64_t aposData = 0;             // cursor (aposData, aposId): continua das linhas anteriores a ele
+    int aposId = 0;                   // 0 = primeira página
+    int limite = 100;
+};
+
+template <typename T>
+struct Pagina {
+    std::vector<T> itens;
+    int64_t proximoData = 0; // usar em FiltroHistorico::aposData
+    int proximoId = 0;       // usar em FiltroHistorico::aposId; 0 = não há mais páginas
+};
+
+// Linhas entregues por cursor (percorrerLeituras/percorrerAlertas): os campos de
+// texto apontam para buffers do repositório e só valem durante o callback.
+struct LeituraView {
+    int id = 0;
+    int userId = 0;
+    std::string_view idSHA;
+    int64_t data = 0;
+    double valor = 0.0;
+    std::string_view caminhoImagem;
+};
+
+struct AlertaView {
+    int id = 0;
+    int userId = 0;
+    double consumo = 0.0;
+    std::string_view mensagem;
+    int64_t data = 0;
+};
+
+// Retornar false interrompe a varredura
+using VisitanteLeitura = std::function<bool(const LeituraView&)>;
+using VisitanteAlerta = std::function<bool(const AlertaView&)>;
+
+// ==================== TEMPO ====================
+// Datas circulam como inteiros (ms desde a epoch); texto só na exibição/e-mail.
+
+inline int64_t agoraEpochMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+inline std::string formatarDataLocal(int64_t epochMs, const char* formato = "%d/%m/%Y %H:%M:%S") {
+    std::time_t t = static_cast<std::time_t>(epochMs / 1000);
+    std::tm tm{};
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    char buf[64];
+    size_t n = std::strftime(buf, sizeof(buf), formato, &tm);
+    return std::string(buf, n);
+}
+
 // ==================== INTERFACES ====================
 
 class IUsuarioRepository {
@@ -75,6 +144,11 @@ public:
     virtual int salvarRegra(int userId, const std::string& tipo, double valor, int extra = 0) = 0;
     virtual std::vector<std::tuple<int, int, std::string, double, int>> listarRegrasPorUsuario(int userId) = 0;
     virtual std::vector<Leitura> listarLeiturasPorUsuario(int userId, int limit = 10) = 0;
+    virtual Pagina<Leitura> listarLeiturasPaginado(const FiltroHistorico& filtro) = 0;
+    virtual Pagina<AlertaRecord> listarAlertasPaginado(const FiltroHistorico& filtro) = 0;
+    // Varredura em streaming (mesma ordem/filtros da paginação; limite <= 0 = sem limite)
+    virtual void percorrerLeituras(const FiltroHistorico& filtro, const VisitanteLeitura& visitante) = 0;
+    virtual void percorrerAlertas(const FiltroHistorico& filtro, const VisitanteAlerta& visitante) = 0;
 };
 
 class IEventoObserver {
@@ -83,4 +157,26 @@ public:
     virtual void atualizar(const DadosAlerta& dados) = 0;
 };
 
+// Observador com entrega que pode falhar (rede, servidor de e-mail...). O
+// despachante de notificações usa isto para retentar em vez de chamar atualizar.
+class ICanalEntrega {
+public:
+    virtual ~ICanalEntrega() = default;
+    // Filtro barato feito na hora de enfileirar (ex: só alertas do dono)
+    virtual bool aceita(const DadosAlerta&) const { return true; }
+    // false = falha temporária, a entrega é tentada de novo mais tarde
+    virtual bool entregar(const DadosAlerta& dados) = 0;
+    // > 0: o despachante junta os alertas que chegarem nessa janela e os
+    // entrega de uma vez por entregarResumo, que devolve quantos alertas do
+    // início do lote saíram; só o resto é retentado
+    virtual std::chrono::milliseconds janelaResumo() const { return std::chrono::milliseconds(0); }
+    virtual size_t entregarResumo(const std::vector<DadosAlerta>& alertas) {
+        size_t entregues = 0;
+        while (entregues < alertas.size() && entregar(alertas[entregues])) entregues++;
+        return entregues;
+    }
+    // Tentativas esgotadas: último recurso (ex: salvar em disco)
+    virtual void desistir(const DadosAlerta&) {}
+};
+
 #endif // CORE_H
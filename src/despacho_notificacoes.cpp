@@ -0,0 +1,244 @@
+#include "despacho_notificacoes.h"
+#include <algorithm>
+
+DespachanteNotificacoes::DespachanteNotificacoes() : DespachanteNotificacoes(Config{}) {}
+
+DespachanteNotificacoes::DespachanteNotificacoes(Config config) : cfg(std::move(config)) {
+    if (cfg.capacidadePorCanal == 0) cfg.capacidadePorCanal = 1;
+    if (cfg.workers == 0) cfg.workers = 1;
+    if (cfg.maxTentativas < 1) cfg.maxTentativas = 1;
+    for (size_t i = 0; i < cfg.workers; ++i) threads.emplace_back(&DespachanteNotificacoes::loopWorker, this);
+}
+
+DespachanteNotificacoes::~DespachanteNotificacoes() {
+    parar();
+}
+
+void DespachanteNotificacoes::adicionarCanal(std::shared_ptr<IEventoObserver> observador) {
+    if (!observador) return;
+    auto canal = std::make_shared<Canal>();
+    canal->entrega = dynamic_cast<ICanalEntrega*>(observador.get());
+    canal->observador = std::move(observador);
+
+    std::lock_guard<std::mutex> lock(canaisM);
+    auto novo = std::make_shared<ListaCanais>(*std::atomic_load(&canais));
+    novo->push_back(std::move(canal));
+    std::atomic_store(&canais, std::shared_ptr<const ListaCanais>(std::move(novo)));
+}
+
+void DespachanteNotificacoes::publicar(const DadosAlerta& dados) {
+    auto lista = std::atomic_load(&canais);
+    for (const auto& canal : *lista) {
+        if (canal->entrega && !canal->entrega->aceita(dados)) continue;
+        enfileirar(*canal, canal, dados);
+    }
+}
+
+void DespachanteNotificacoes::enfileirar(Canal& canal, const std::shared_ptr<Canal>& ref, const DadosAlerta& dados) {
+    bool agendar = false;
+    {
+        std::lock_guard<std::mutex> lock(canal.m);
+        if (canal.fila.size() >= cfg.capacidadePorCanal) {
+            // Canal atrasado. Descartes não chamam desistir(): o alerta já está
+            // no histórico e gravar em disco aqui deixaria o monitor esperando.
+            if (cfg.politica == PoliticaFila::DESCARTAR_NOVO) {
+                descartados++;
+                return;
+            }
+            if (cfg.politica == PoliticaFila::COALESCER) {
+                auto it = std::find_if(canal.fila.rbegin(), canal.fila.rend(),
+                                       [&](const Pendente& p) { return p.dados.userId == dados.userId; });
+                if (it != canal.fila.rend()) {
+                    it->dados = dados; // fica o consumo mais recente, na posição do antigo
+                    coalescidos++;
+                    return;
+                }
+            }
+            canal.fila.pop_front();
+            descartados++;
+        }
+        canal.fila.push_back(Pendente{dados, 0});
+        publicados++;
+        if (!canal.agendado) {
+            canal.agendado = true;
+            agendar = true;
+        }
+    }
+    if (agendar) {
+        // Canal com resumo espera a janela juntando o que chegar nesse meio tempo
+        auto janela = canal.entrega ? canal.entrega->janelaResumo() : std::chrono::milliseconds(0);
+        {
+            std::lock_guard<std::mutex> lock(m);
+            // Encerrando, o resumo não espera a janela
+            if (janela.count() > 0 && !parando) adiados.push({Relogio::now() + janela, ref});
+            else prontos.push_back(ref);
+        }
+        cv.notify_one();
+    }
+}
+
+void DespachanteNotificacoes::loopWorker() {
+    for (;;) {
+        std::shared_ptr<Canal> canal;
+        {
+            std::unique_lock<std::mutex> lock(m);
+            for (;;) {
+                auto agora = Relogio::now();
+                while (!adiados.empty() && adiados.top().first <= agora) {
+                    prontos.push_back(adiados.top().second);
+                    adiados.pop();
+                }
+                if (!prontos.empty()) {
+                    canal = std::move(prontos.front());
+                    prontos.pop_front();
+                    break;
+                }
+                if (parando) return;
+                if (adiados.empty()) cv.wait(lock);
+                else cv.wait_until(lock, adiados.top().first);
+            }
+        }
+        atender(canal);
+    }
+}
+
+void DespachanteNotificacoes::atender(const std::shared_ptr<Canal>& canal) {
+    const auto janela = canal->entrega ? canal->entrega->janelaResumo() : std::chrono::milliseconds(0);
+    std::vector<Pendente> lote;
+    {
+        std::lock_guard<std::mutex> lock(canal->m);
+        if (canal->fila.empty()) {
+            canal->agendado = false;
+            return;
+        }
+        // Sem resumo sai um alerta por vez; com resumo, tudo o que juntou na janela
+        size_t n = janela.count() > 0 ? canal->fila.size() : 1;
+        for (size_t i = 0; i < n; ++i) {
+            lote.push_back(std::move(canal->fila.front()));
+            canal->fila.pop_front();
+        }
+    }
+
+    // Quantos alertas do início do lote saíram; os demais voltam para a fila
+    size_t feitos = 0;
+    try {
+        if (!canal->entrega) {
+            canal->observador->atualizar(lote.front().dados);
+            feitos = 1;
+        } else if (lote.size() == 1) {
+            feitos = canal->entrega->entregar(lote.front().dados) ? 1 : 0;
+        } else {
+            std::vector<DadosAlerta> alertas;
+            alertas.reserve(lote.size());
+            for (const auto& p : lote) alertas.push_back(p.dados);
+            feitos = std::min(canal->entrega->entregarResumo(alertas), lote.size());
+            if (feitos == lote.size()) resumos++;
+        }
+    } catch (...) {
+        feitos = 0;
+    }
+    const bool ok = feitos == lote.size();
+
+    std::vector<DadosAlerta> desistidos;
+    bool adiar = false, reagendar = false;
+    Relogio::time_point retomarEm;
+    {
+        std::lock_guard<std::mutex> lock(canal->m);
+        entregues += feitos;
+        if (ok) {
+            canal->backoff = std::chrono::milliseconds(0);
+        } else {
+            canal->backoff = canal->backoff.count() == 0
+                ? cfg.backoffInicial
+                : std::min(canal->backoff * 2, cfg.backoffMaximo);
+            // Só o que não saiu, de trás para frente para voltar à frente da fila na mesma ordem
+            for (auto it = lote.rbegin(); it != lote.rend() - feitos; ++it) {
+                if (++it->tentativas < cfg.maxTentativas) {
+                    retentativas++;
+                    canal->fila.push_front(std::move(*it));
+                } else {
+                    desistencias++;
+                    desistidos.push_back(std::move(it->dados));
+                }
+            }
+        }
+        // Depois de uma falha o canal inteiro espera o backoff, não só o alerta
+        if (canal->fila.empty()) canal->agendado = false;
+        else if (!ok) adiar = true;
+        else reagendar = true;
+        retomarEm = Relogio::now() + (adiar ? canal->backoff : janela);
+    }
+
+    if (canal->entrega) {
+        for (const auto& d : desistidos) canal->entrega->desistir(d);
+    }
+
+    if (adiar || reagendar) {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            // Volta para o fim da fila de prontos: um alerta (ou lote) por canal por vez.
+            // Encerrando, o resumo sai sem esperar outra janela até a fila esvaziar.
+            if (adiar || (janela.count() > 0 && !parando)) adiados.push({retomarEm, canal});
+            else prontos.push_back(canal);
+        }
+        cv.notify_one();
+    }
+}
+
+void DespachanteNotificacoes::parar() {
+    {
+        std::lock_guard<std::mutex> lock(m);
+        if (parando && threads.empty()) return;
+        parando = true;
+        // Resumos esperando a janela saem agora; canais em backoff continuam adiados
+        std::vector<Adiado> manter;
+        while (!adiados.empty()) {
+            Adiado a = adiados.top();
+            adiados.pop();
+            bool emBackoff;
+            {
+                std::lock_guard<std::mutex> lockCanal(a.second->m);
+                emBackoff = a.second->backoff.count() > 0;
+            }
+            if (emBackoff) manter.push_back(std::move(a));
+            else prontos.push_back(std::move(a.second));
+        }
+        for (auto& a : manter) adiados.push(std::move(a));
+    }
+    cv.notify_all();
+    for (auto& t : threads) {
+        if (t.joinable()) t.join();
+    }
+    threads.clear();
+
+    for (const auto& canal : *std::atomic_load(&canais)) {
+        std::deque<Pendente> restantes;
+        {
+            std::lock_guard<std::mutex> lock(canal->m);
+            restantes.swap(canal->fila);
+            canal->agendado = false;
+        }
+        for (const auto& p : restantes) {
+            desistencias++;
+            if (canal->entrega) canal->entrega->desistir(p.dados);
+        }
+    }
+}
+
+DespachanteNotificacoes::Estatisticas DespachanteNotificacoes::estatisticas() const {
+    Estatisticas e;
+    e.publicados = publicados.load();
+    e.entregues = entregues.load();
+    e.retentativas = retentativas.load();
+    e.desistencias = desistencias.load();
+    e.coalescidos = coalescidos.load();
+    e.descartados = descartados.load();
+    e.resumos = resumos.load();
+    auto lista = std::atomic_load(&canais);
+    e.canais = lista->size();
+    for (const auto& canal : *lista) {
+        std::lock_guard<std::mutex> lock(canal->m);
+        e.pendentes += canal->fila.size();
+    }
+    return e;
+}
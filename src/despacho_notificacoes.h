@@ -0,0 +1,117 @@
+#ifndef DESPACHO_NOTIFICACOES_H
+#define DESPACHO_NOTIFICACOES_H
+
+#include "core.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <queue>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Entrega assíncrona de alertas. Cada observador registrado vira um canal com
+// fila limitada; publicar() só enfileira e volta. Workers dedicados (threads
+// próprias, não o PoolTarefas, porque a entrega bloqueia em rede) atendem um
+// alerta por vez de cada canal pronto, em rodízio, e nunca dois workers no
+// mesmo canal. Canal que falha fica em backoff exponencial sem travar os
+// outros; canal que não acompanha o ritmo coalesce ou descarta pela política.
+// Canal com janelaResumo() recebe os alertas da janela num lote só.
+class DespachanteNotificacoes {
+public:
+    using Relogio = std::chrono::steady_clock;
+
+    enum class PoliticaFila {
+        COALESCER,             // substitui o alerta pendente do mesmo usuário; sem ele, descarta o mais antigo
+        DESCARTAR_MAIS_ANTIGO,
+        DESCARTAR_NOVO
+    };
+
+    struct Config {
+        size_t capacidadePorCanal = 64;
+        size_t workers = 2;
+        int maxTentativas = 5;
+        std::chrono::milliseconds backoffInicial{1000};
+        std::chrono::milliseconds backoffMaximo{60000};
+        PoliticaFila politica = PoliticaFila::COALESCER;
+    };
+
+    struct Estatisticas {
+        uint64_t publicados = 0;   // alertas enfileirados (soma dos canais)
+        uint64_t entregues = 0;
+        uint64_t retentativas = 0;
+        uint64_t desistencias = 0; // tentativas esgotadas
+        uint64_t coalescidos = 0;
+        uint64_t descartados = 0;
+        uint64_t resumos = 0;      // lotes entregues de uma vez (janelaResumo)
+        size_t pendentes = 0;
+        size_t canais = 0;
+    };
+
+    DespachanteNotificacoes();
+    explicit DespachanteNotificacoes(Config cfg);
+    ~DespachanteNotificacoes();
+    DespachanteNotificacoes(const DespachanteNotificacoes&) = delete;
+    DespachanteNotificacoes& operator=(const DespachanteNotificacoes&) = delete;
+
+    void adicionarCanal(std::shared_ptr<IEventoObserver> observador);
+    void publicar(const DadosAlerta& dados);
+
+    // Entrega o que já está pronto, inclusive resumos (até a fila do canal
+    // esvaziar), e encerra os workers. Canais em backoff não são esperados: o
+    // que restar neles vai para desistir()
+    void parar();
+
+    Estatisticas estatisticas() const;
+
+private:
+    struct Pendente {
+        DadosAlerta dados;
+        int tentativas = 0;
+    };
+
+    struct Canal {
+        std::shared_ptr<IEventoObserver> observador;
+        ICanalEntrega* entrega = nullptr; // o mesmo objeto, se souber informar falha
+        std::mutex m;
+        std::deque<Pendente> fila;
+        bool agendado = false;            // em prontos, em adiados ou com um worker
+        std::chrono::milliseconds backoff{0};
+    };
+
+    using ListaCanais = std::vector<std::shared_ptr<Canal>>;
+
+    Config cfg;
+    // Lista de canais publicada como snapshot imutável: publicar() não trava a lista
+    std::shared_ptr<const ListaCanais> canais = std::make_shared<const ListaCanais>();
+    std::mutex canaisM; // serializa apenas quem adiciona canais
+
+    mutable std::mutex m; // prontos, adiados e parando
+    std::condition_variable cv;
+    std::deque<std::shared_ptr<Canal>> prontos;
+    using Adiado = std::pair<Relogio::time_point, std::shared_ptr<Canal>>;
+    struct AdiadoDepois {
+        bool operator()(const Adiado& a, const Adiado& b) const { return a.first > b.first; }
+    };
+    std::priority_queue<Adiado, std::vector<Adiado>, AdiadoDepois> adiados;
+    bool parando = false;
+    std::vector<std::thread> threads;
+
+    std::atomic<uint64_t> publicados{0};
+    std::atomic<uint64_t> entregues{0};
+    std::atomic<uint64_t> retentativas{0};
+    std::atomic<uint64_t> desistencias{0};
+    std::atomic<uint64_t> coalescidos{0};
+    std::atomic<uint64_t> descartados{0};
+    std::atomic<uint64_t> resumos{0};
+
+    void enfileirar(Canal& canal, const std::shared_ptr<Canal>& ref, const DadosAlerta& dados);
+    void loopWorker();
+    void atender(const std::shared_ptr<Canal>& canal);
+};
+
+#endif // DESPACHO_NOTIFICACOES_H
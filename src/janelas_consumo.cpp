@@ -0,0 +1,113 @@
+#include "janelas_consumo.h"
+
+// ==================== JANELA MOVEL ====================
+JanelaMovel::JanelaMovel(size_t capacidade) : valores(capacidade > 0 ? capacidade : 1, 0.0) {}
+
+void JanelaMovel::inserir(double valor) {
+    std::lock_guard<std::mutex> lock(m);
+    const size_t cap = valores.size();
+    if (quantidade == cap) {
+        soma -= valores[proxima];
+    } else {
+        quantidade++;
+    }
+    valores[proxima] = valor;
+    soma += valor;
+    proxima = (proxima + 1) % cap;
+
+    // Recalcula a cada volta: custo O(capacidade) a cada `capacidade` inserções
+    if (++desdeRecalculo >= cap) {
+        desdeRecalculo = 0;
+        double exata = 0.0;
+        for (size_t i = 0; i < quantidade; ++i) exata += valores[i];
+        soma = exata;
+    }
+}
+
+bool JanelaMovel::media(double& saida) const {
+    std::lock_guard<std::mutex> lock(m);
+    if (quantidade == 0) return false;
+    saida = soma / static_cast<double>(quantidade);
+    return true;
+}
+
+size_t JanelaMovel::tamanho() const {
+    std::lock_guard<std::mutex> lock(m);
+    return quantidade;
+}
+
+// ==================== JANELAS POR USUARIO ====================
+std::shared_ptr<JanelaMovel> JanelasConsumo::obterJanela(int userId, size_t capacidade, IHistoricoRepository* aquecimento) {
+    Shard& shard = shardDe(userId);
+    // A consulta de aquecimento roda com o shard travado: uma leitura ingerida
+    // enquanto isso espera e entra depois, sem ser contada duas vezes
+    std::unique_lock<std::shared_mutex> lock(shard.m);
+    auto& lista = shard.porUsuario[userId];
+    for (const auto& j : lista) {
+        if (j->capacidade() == capacidade) return j;
+    }
+
+    auto janela = std::make_shared<JanelaMovel>(capacidade);
+    if (aquecimento) {
+        // Vem da mais recente para a mais antiga
+        auto recentes = aquecimento->listarLeiturasPorUsuario(userId, static_cast<int>(janela->capacidade()));
+        for (auto it = recentes.rbegin(); it != recentes.rend(); ++it) janela->inserir(it->valor);
+    }
+    lista.push_back(janela);
+    return janela;
+}
+
+void JanelasConsumo::registrarLeitura(int userId, double valor) {
+    Shard& shard = shardDe(userId);
+    std::shared_lock<std::shared_mutex> lock(shard.m);
+    auto it = shard.porUsuario.find(userId);
+    if (it == shard.porUsuario.end()) return;
+    for (const auto& j : it->second) j->inserir(valor);
+}
+
+// ==================== DECORATOR ====================
+HistoricoRepositoryJanelas::HistoricoRepositoryJanelas(std::shared_ptr<IHistoricoRepository> repo, std::shared_ptr<JanelasConsumo> janelas)
+    : origem(std::move(repo)), janelas(std::move(janelas)) {}
+
+void HistoricoRepositoryJanelas::salvarLeitura(const Leitura& leitura) {
+    // Janela antes do banco: se o aquecimento estiver consultando agora, esta
+    // leitura ainda não está lá e entra só uma vez
+    janelas->registrarLeitura(leitura.userId, leitura.valor);
+    origem->salvarLeitura(leitura);
+}
+
+void HistoricoRepositoryJanelas::salvarAlerta(const AlertaRecord& alerta) {
+    origem->salvarAlerta(alerta);
+}
+
+std::vector<AlertaRecord> HistoricoRepositoryJanelas::listarAlertasPorUsuario(int userId) {
+    return origem->listarAlertasPorUsuario(userId);
+}
+
+int HistoricoRepositoryJanelas::salvarRegra(int userId, const std::string& tipo, double valor, int extra) {
+    return origem->salvarRegra(userId, tipo, valor, extra);
+}
+
+std::vector<std::tuple<int, int, std::string, double, int>> HistoricoRepositoryJanelas::listarRegrasPorUsuario(int userId) {
+    return origem->listarRegrasPorUsuario(userId);
+}
+
+std::vector<Leitura> HistoricoRepositoryJanelas::listarLeiturasPorUsuario(int userId, int limit) {
+    return origem->listarLeiturasPorUsuario(userId, limit);
+}
+
+Pagina<Leitura> HistoricoRepositoryJanelas::listarLeiturasPaginado(const FiltroHistorico& filtro) {
+    return origem->listarLeiturasPaginado(filtro);
+}
+
+Pagina<AlertaRecord> HistoricoRepositoryJanelas::listarAlertasPaginado(const FiltroHistorico& filtro) {
+    return origem->listarAlertasPaginado(filtro);
+}
+
+void HistoricoRepositoryJanelas::percorrerLeituras(const FiltroHistorico& filtro, const VisitanteLeitura& visitante) {
+    origem->percorrerLeituras(filtro, visitante);
+}
+
+void HistoricoRepositoryJanelas::percorrerAlertas(const FiltroHistorico& filtro, const VisitanteAlerta& visitante) {
+    origem->percorrerAlertas(filtro, visitante);
+}
@@ -0,0 +1,78 @@
+#ifndef JANELAS_CONSUMO_H
+#define JANELAS_CONSUMO_H
+
+#include "core.h"
+#include <vector>
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <cstddef>
+
+// Janela deslizante de capacidade fixa com soma corrente: inserir e media são
+// O(1) e nada é alocado depois da construção. A soma é refeita do zero a cada
+// volta completa do anel para não acumular erro de ponto flutuante.
+class JanelaMovel {
+public:
+    explicit JanelaMovel(size_t capacidade);
+
+    void inserir(double valor);
+    // false se a janela ainda está vazia
+    bool media(double& saida) const;
+
+    size_t tamanho() const;
+    size_t capacidade() const { return valores.size(); }
+
+private:
+    mutable std::mutex m;
+    std::vector<double> valores;
+    size_t proxima = 0;     // posição onde entra o próximo valor
+    size_t quantidade = 0;
+    size_t desdeRecalculo = 0;
+    double soma = 0.0;
+};
+
+// Janelas de média móvel por usuário. Cada regra de média móvel pede a sua
+// (reaproveitada se já houver uma com a mesma capacidade) e toda leitura
+// ingerida para o usuário entra em todas as janelas dele.
+class JanelasConsumo {
+public:
+    // Cria a janela aquecida com as últimas leituras do repositório (só na criação)
+    std::shared_ptr<JanelaMovel> obterJanela(int userId, size_t capacidade, IHistoricoRepository* aquecimento);
+    void registrarLeitura(int userId, double valor);
+
+private:
+    static constexpr size_t NUM_SHARDS = 16;
+    struct Shard {
+        std::shared_mutex m;
+        std::unordered_map<int, std::vector<std::shared_ptr<JanelaMovel>>> porUsuario;
+    };
+    std::array<Shard, NUM_SHARDS> shards;
+
+    Shard& shardDe(int userId) { return shards[static_cast<size_t>(userId) % NUM_SHARDS]; }
+};
+
+// Decorator sobre IHistoricoRepository que alimenta as janelas a cada leitura
+// salva; o resto é repassado sem mudança.
+class HistoricoRepositoryJanelas : public IHistoricoRepository {
+private:
+    std::shared_ptr<IHistoricoRepository> origem;
+    std::shared_ptr<JanelasConsumo> janelas;
+
+public:
+    HistoricoRepositoryJanelas(std::shared_ptr<IHistoricoRepository> repo, std::shared_ptr<JanelasConsumo> janelas);
+
+    void salvarLeitura(const Leitura& leitura) override;
+    void salvarAlerta(const AlertaRecord& alerta) override;
+    std::vector<AlertaRecord> listarAlertasPorUsuario(int userId) override;
+    int salvarRegra(int userId, const std::string& tipo, double valor, int extra = 0) override;
+    std::vector<std::tuple<int, int, std::string, double, int>> listarRegrasPorUsuario(int userId) override;
+    std::vector<Leitura> listarLeiturasPorUsuario(int userId, int limit = 10) override;
+    Pagina<Leitura> listarLeiturasPaginado(const FiltroHistorico& filtro) override;
+    Pagina<AlertaRecord> listarAlertasPaginado(const FiltroHistorico& filtro) override;
+    void percorrerLeituras(const FiltroHistorico& filtro, const VisitanteLeitura& visitante) override;
+    void percorrerAlertas(const FiltroHistorico& filtro, const VisitanteAlerta& visitante) override;
+};
+
+#endif // JANELAS_CONSUMO_H
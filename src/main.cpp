@@ -2,7 +2,16 @@
 #ifdef USE_SQLITE3
 #include "sqlite_repository.h"
 #endif
+#include "memory_repository.h"
+#include "cache_repository.h"
 #include "smtp_email.h"
+#include "preprocessamento.h"
+#include "reconhecedor_digitos.h"
+#include "pool_tarefas.h"
+#include "roda_temporizacao.h"
+#include "janelas_consumo.h"
+#include "cooldown_alertas.h"
+#include "despacho_notificacoes.h"
 #include <iostream>
 #include <memory>
 #include <map>
@@ -24,31 +33,26 @@
 #ifdef _WIN32
 #include <windows.h>
 #endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
 #include <cstdint>
+#include <unordered_map>
+#include <future>
+#include <list>
+#include <array>
+#include <functional>
+#include <set>
+#include <condition_variable>
+#ifdef USE_TESSERACT
+#include <tesseract/baseapi.h>
+#include <leptonica/allheaders.h>
+#endif
 
 namespace fs = std::filesystem;
 
-class UsuarioRepositoryMemory : public IUsuarioRepository {
-public:
-    Usuario salvar(const Usuario& user) override { return user; }
-    std::optional<Usuario> buscarPorLogin(const std::string&) override { return std::nullopt; }
-    std::optional<Usuario> buscarPorId(int) override { return std::nullopt; }
-    void deletar(int) override {}
-    void vincularHidrometro(int, const std::string&) override {}
-    void desvincularHidrometro(int, const std::string&) override {}
-    std::vector<Usuario> listarTodosUsuarios() override { return {}; }
-};
-
-class HistoricoRepositoryMemory : public IHistoricoRepository {
-public:
-    void salvarLeitura(const Leitura&) override {}
-    void salvarAlerta(const AlertaRecord&) override {}
-    std::vector<AlertaRecord> listarAlertasPorUsuario(int) override { return {}; }
-    int salvarRegra(int, const std::string&, double, int) override { return 0; }
-    std::vector<std::tuple<int, int, std::string, double, int>> listarRegrasPorUsuario(int) override { return {}; }
-    std::vector<Leitura> listarLeiturasPorUsuario(int, int) override { return {}; }
-};
-
 // ==================== LOGGER ====================
 class LogManager {
 private:
@@ -79,6 +83,28 @@ public:
     virtual std::string obterCaminhoArquivoImagem() = 0;
 };
 
+// Extensão sem diferenciar maiúsculas (".PNG" também vale)
+static bool ehArquivoDeImagem(const fs::path& p) {
+    std::string ext = p.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".pgm" || ext == ".ppm" || ext == ".txt";
+}
+
+// Uma passada pelo diretório guardando o arquivo de maior mtime ("" se não houver imagens)
+static std::string buscarImagemMaisRecente(const fs::path& dir) {
+    std::string maisRecente;
+    fs::file_time_type dataMaisRecente{};
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (!entry.is_regular_file() || !ehArquivoDeImagem(entry.path())) continue;
+        auto data = entry.last_write_time();
+        if (maisRecente.empty() || data > dataMaisRecente) {
+            maisRecente = entry.path().string();
+            dataMaisRecente = data;
+        }
+    }
+    return maisRecente;
+}
+
 class AdapterSimuladorArquivo : public ISimuladorAdapter {
 private:
     std::string caminhoBase;
@@ -91,25 +117,206 @@ public:
         fs::path dir(caminhoBase);
         if (!fs::exists(dir)) throw std::runtime_error("Diretório não existe: " + caminhoBase);
 
-        std::vector<fs::path> arquivos;
-        for (const auto& entry : fs::directory_iterator(dir)) {
-            if (entry.is_regular_file()) {
-                std::string ext = entry.path().extension().string();
-                if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".txt") {
-                    arquivos.push_back(entry.path());
+        std::string maisRecente = buscarImagemMaisRecente(dir);
+        if (maisRecente.empty()) throw std::runtime_error("Nenhuma imagem encontrada em: " + caminhoBase);
+        return maisRecente;
+    }
+};
+
+#ifdef __linux__
+// Acompanha, via um único descritor inotify, a imagem mais recente de cada pasta
+// de simulador. Cada pasta é varrida uma vez ao ser registrada; depois só os
+// eventos atualizam o estado. Em overflow da fila de eventos, tudo é revarrido.
+class MonitorImagens {
+public:
+    struct Estado {
+        std::mutex m;
+        fs::path dir;
+        std::string maisRecente;
+        bool existe = true;
+    };
+
+    static MonitorImagens& getInstance() {
+        std::lock_guard<std::mutex> lock(instanceMutex);
+        if (!instance) instance = new MonitorImagens();
+        return *instance;
+    }
+
+    std::shared_ptr<Estado> registrar(const std::string& caminho) {
+        std::lock_guard<std::mutex> lock(m);
+        auto existente = wdPorCaminho.find(caminho);
+        if (existente != wdPorCaminho.end()) {
+            if (auto estado = porWd[existente->second].lock()) return estado;
+        }
+
+        int wd = inotify_add_watch(fd, caminho.c_str(),
+                                   IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF | IN_MOVE_SELF);
+        if (wd < 0) throw std::runtime_error("inotify_add_watch falhou: " + caminho);
+
+        auto estado = std::make_shared<Estado>();
+        estado->dir = caminho;
+        revarrer(*estado);
+        porWd[wd] = estado;
+        wdPorCaminho[caminho] = wd;
+        return estado;
+    }
+
+    uint64_t totalRevarreduras() const { return revarreduras.load(); }
+
+private:
+    static MonitorImagens* instance;
+    static std::mutex instanceMutex;
+
+    int fd = -1;
+    std::thread leitor;
+    std::mutex m;
+    std::unordered_map<int, std::weak_ptr<Estado>> porWd;
+    std::map<std::string, int> wdPorCaminho;
+    std::atomic<uint64_t> revarreduras{0};
+
+    MonitorImagens() {
+        fd = inotify_init1(IN_CLOEXEC);
+        if (fd < 0) throw std::runtime_error("inotify_init1 falhou");
+        leitor = std::thread(&MonitorImagens::loop, this);
+        leitor.detach();
+    }
+
+    void revarrer(Estado& estado) {
+        revarreduras++;
+        std::string maisRecente;
+        bool existe = true;
+        try {
+            existe = fs::exists(estado.dir);
+            if (existe) maisRecente = buscarImagemMaisRecente(estado.dir);
+        } catch (...) {
+            existe = false;
+        }
+        std::lock_guard<std::mutex> lock(estado.m);
+        estado.existe = existe;
+        estado.maisRecente = maisRecente;
+    }
+
+    std::shared_ptr<Estado> buscar(int wd) {
+        std::lock_guard<std::mutex> lock(m);
+        auto it = porWd.find(wd);
+        return it != porWd.end() ? it->second.lock() : nullptr;
+    }
+
+    void revarrerTodos() {
+        std::vector<std::shared_ptr<Estado>> vivos;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            for (auto& [wd, fraco] : porWd) {
+                if (auto estado = fraco.lock()) vivos.push_back(estado);
+            }
+        }
+        for (auto& estado : vivos) revarrer(*estado);
+    }
+
+    // Remove watches de pastas que nenhum adapter usa mais
+    void limparExpirados() {
+        std::lock_guard<std::mutex> lock(m);
+        for (auto it = wdPorCaminho.begin(); it != wdPorCaminho.end();) {
+            auto wdIt = porWd.find(it->second);
+            if (wdIt == porWd.end() || wdIt->second.expired()) {
+                if (wdIt != porWd.end()) {
+                    inotify_rm_watch(fd, it->second);
+                    porWd.erase(wdIt);
                 }
+                it = wdPorCaminho.erase(it);
+            } else {
+                ++it;
             }
         }
+    }
 
-        if (arquivos.empty()) throw std::runtime_error("Nenhuma imagem encontrada em: " + caminhoBase);
+    void esquecer(int wd) {
+        std::lock_guard<std::mutex> lock(m);
+        porWd.erase(wd);
+        for (auto it = wdPorCaminho.begin(); it != wdPorCaminho.end(); ++it) {
+            if (it->second == wd) { wdPorCaminho.erase(it); break; }
+        }
+    }
 
-        std::sort(arquivos.begin(), arquivos.end(), [](const fs::path& a, const fs::path& b) {
-            return fs::last_write_time(a) > fs::last_write_time(b);
-        });
+    void tratarEvento(const inotify_event& ev) {
+        if (ev.mask & IN_Q_OVERFLOW) {
+            revarrerTodos();
+            return;
+        }
+        auto estado = buscar(ev.wd);
+        if (!estado) return;
+
+        if (ev.mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+            std::lock_guard<std::mutex> lock(estado->m);
+            estado->existe = false;
+            estado->maisRecente.clear();
+            if (ev.mask & IN_IGNORED) {
+                // O kernel já descartou o watch; uma nova conexão registra de novo
+                esquecer(ev.wd);
+            }
+            return;
+        }
+        if (ev.len == 0) return;
+
+        fs::path arquivo = estado->dir / ev.name;
+        if (!ehArquivoDeImagem(arquivo)) return;
+
+        if (ev.mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+            // Acabou de ser escrito/movido para cá: é a imagem mais recente
+            std::lock_guard<std::mutex> lock(estado->m);
+            estado->maisRecente = arquivo.string();
+        } else if (ev.mask & (IN_DELETE | IN_MOVED_FROM)) {
+            bool eraAtual;
+            {
+                std::lock_guard<std::mutex> lock(estado->m);
+                eraAtual = (estado->maisRecente == arquivo.string());
+            }
+            if (eraAtual) revarrer(*estado);
+        }
+    }
 
-        return arquivos[0].string();
+    void loop() {
+        alignas(inotify_event) char buf[64 * 1024];
+        pollfd pfd{fd, POLLIN, 0};
+        while (true) {
+            int r = poll(&pfd, 1, 5000);
+            if (r == 0) {
+                limparExpirados();
+                continue;
+            }
+            if (r < 0) continue;
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0) continue;
+            for (char* p = buf; p < buf + n;) {
+                auto* ev = reinterpret_cast<inotify_event*>(p);
+                try { tratarEvento(*ev); } catch (...) {}
+                p += sizeof(inotify_event) + ev->len;
+            }
+        }
     }
 };
+MonitorImagens* MonitorImagens::instance = nullptr;
+std::mutex MonitorImagens::instanceMutex;
+
+// Mesmo contrato do AdapterSimuladorArquivo, mas responde em O(1) a partir do
+// estado mantido pelo MonitorImagens (sem listar o diretório a cada leitura).
+class AdapterSimuladorArquivoEventos : public ISimuladorAdapter {
+private:
+    std::string caminhoBase;
+    std::string idSHA;
+    std::shared_ptr<MonitorImagens::Estado> estado;
+public:
+    AdapterSimuladorArquivoEventos(const std::string& caminho, const std::string& sha = "")
+        : caminhoBase(caminho), idSHA(sha), estado(MonitorImagens::getInstance().registrar(caminho)) {}
+
+    std::string obterCaminhoArquivoImagem() override {
+        std::lock_guard<std::mutex> lock(estado->m);
+        if (!estado->existe) throw std::runtime_error("Diretório não existe: " + caminhoBase);
+        if (estado->maisRecente.empty()) throw std::runtime_error("Nenhuma imagem encontrada em: " + caminhoBase);
+        return estado->maisRecente;
+    }
+};
+#endif
 
 // ==================== FACTORY ====================
 class SimuladorFactory {
@@ -121,6 +328,16 @@ public:
         if (caminho == params.end()) throw std::runtime_error("Parâmetro 'caminho' obrigatório");
         auto idSHA = params.find("idSHA");
         std::string sha = (idSHA != params.end()) ? idSHA->second : "";
+        auto modo = params.find("modo");
+        if (modo != params.end() && modo->second == "eventos") {
+#ifdef __linux__
+            try {
+                return std::make_shared<AdapterSimuladorArquivoEventos>(caminho->second, sha);
+            } catch (const std::exception& e) {
+                LogManager::getInstance().log(std::string("[Adapter] Sem inotify, usando varredura: ") + e.what());
+            }
+#endif
+        }
         return std::make_shared<AdapterSimuladorArquivo>(caminho->second, sha);
     }
 };
@@ -130,26 +347,493 @@ class IOcrStrategy {
 public:
     virtual ~IOcrStrategy() = default;
     virtual double extrairLeitura(const std::string& caminhoImagem) = 0;
+    // Lote: a implementação padrão é sequencial; estratégias caras sobrescrevem para paralelizar
+    virtual std::vector<double> extrairLeiturasEmLote(const std::vector<std::string>& caminhos) {
+        std::vector<double> valores;
+        valores.reserve(caminhos.size());
+        for (const auto& c : caminhos) valores.push_back(extrairLeitura(c));
+        return valores;
+    }
+    // Imagem já recortada e binarizada em memória (PreprocessamentoOcrStrategy).
+    // `caminhoOriginal` identifica a imagem para quem lê o valor pelo nome; o
+    // padrão ignora os pixels e lê pelo caminho.
+    virtual double extrairLeituraPreprocessada(const Imagem& binaria, const std::string& caminhoOriginal) {
+        (void)binaria;
+        return extrairLeitura(caminhoOriginal);
+    }
+    virtual std::vector<double> extrairLeiturasPreprocessadasEmLote(const std::vector<Imagem>& binarias,
+                                                                     const std::vector<std::string>& caminhosOriginais) {
+        std::vector<double> valores;
+        valores.reserve(binarias.size());
+        for (size_t i = 0; i < binarias.size(); ++i) {
+            valores.push_back(extrairLeituraPreprocessada(binarias[i], caminhosOriginais[i]));
+        }
+        return valores;
+    }
 };
 
+// Primeiro número (inteiro ou decimal) do texto, se houver
+static bool extrairPrimeiroNumero(const std::string& texto, double& valor) {
+    static const std::regex numRegex("(\\d+(\\.\\d+)?)");
+    std::smatch match;
+    if (!std::regex_search(texto, match, numRegex)) return false;
+    try { valor = std::stod(match[1].str()); } catch(...) { return false; }
+    return true;
+}
+
 class FilenameOcrStrategy : public IOcrStrategy {
 public:
     double extrairLeitura(const std::string& caminhoImagem) override {
-        fs::path p(caminhoImagem);
-        std::string filename = p.stem().string();
-        std::regex numRegex("(\\d+(\\.\\d+)?)");
-        std::smatch match;
-        if (std::regex_search(filename, match, numRegex)) {
-            try { return std::stod(match[1].str()); } catch(...) { return 0.0; }
-        }
-        return 0.0;
+        double valor = 0.0;
+        extrairPrimeiroNumero(fs::path(caminhoImagem).stem().string(), valor);
+        return valor;
     }
 };
 
+// OCR real via Tesseract (compilar com USE_TESSERACT). Inicializar um
+// TessBaseAPI custa centenas de ms, então os engines ficam num pool: cada um é
+// criado e configurado (idioma + whitelist de dígitos) uma única vez e depois
+// reaproveitado; no máximo um por thread trabalhando ao mesmo tempo.
+// Sem Tesseract, ou para arquivos que não são imagem (.txt dos simuladores),
+// cai no FilenameOcrStrategy.
 class TesseractOcrStrategy : public IOcrStrategy {
 public:
+    struct Config {
+        std::string tessdata;                 // vazio = TESSDATA_PREFIX / padrão da instalação
+        std::string idioma = "eng";
+        std::string whitelist = "0123456789.";
+        size_t maxEngines = 0;                // 0 = número de núcleos
+    };
+    struct Estatisticas {
+        uint64_t imagens = 0;
+        uint64_t lotes = 0;
+        size_t engines = 0;
+        double segundosEmLote = 0.0;
+        double imagensPorSegundo() const { return segundosEmLote > 0 ? imagens / segundosEmLote : 0.0; }
+    };
+
+    TesseractOcrStrategy() : TesseractOcrStrategy(Config{}) {}
+    explicit TesseractOcrStrategy(Config c) : cfg(std::move(c)) {
+        if (cfg.maxEngines == 0) cfg.maxEngines = std::max(1u, std::thread::hardware_concurrency());
+    }
+    ~TesseractOcrStrategy() override {
+#ifdef USE_TESSERACT
+        std::lock_guard<std::mutex> lock(poolM);
+        for (auto& e : engines) {
+            if (e) e->End();
+        }
+#endif
+    }
+
     double extrairLeitura(const std::string& caminhoImagem) override {
-        return FilenameOcrStrategy().extrairLeitura(caminhoImagem);
+        imagens++;
+        return reconhecer(caminhoImagem);
+    }
+
+    std::vector<double> extrairLeiturasEmLote(const std::vector<std::string>& caminhos) override {
+        return emLote(caminhos.size(), [&](size_t i) { return reconhecer(caminhos[i]); });
+    }
+
+    double extrairLeituraPreprocessada(const Imagem& binaria, const std::string& caminhoOriginal) override {
+        imagens++;
+        return reconhecer(binaria, caminhoOriginal);
+    }
+
+    std::vector<double> extrairLeiturasPreprocessadasEmLote(const std::vector<Imagem>& binarias,
+                                                             const std::vector<std::string>& caminhosOriginais) override {
+        return emLote(binarias.size(), [&](size_t i) { return reconhecer(binarias[i], caminhosOriginais[i]); });
+    }
+
+    Estatisticas estatisticas() const {
+        Estatisticas e;
+        e.imagens = imagens.load();
+        e.lotes = lotes.load();
+        e.segundosEmLote = microsEmLote.load() / 1e6;
+#ifdef USE_TESSERACT
+        std::lock_guard<std::mutex> lock(poolM);
+        e.engines = engines.size();
+#endif
+        return e;
+    }
+
+private:
+    Config cfg;
+    FilenameOcrStrategy fallback;
+    std::atomic<uint64_t> imagens{0};
+    std::atomic<uint64_t> lotes{0};
+    std::atomic<uint64_t> microsEmLote{0};
+
+#ifdef USE_TESSERACT
+    mutable std::mutex poolM;
+    std::condition_variable poolCv;
+    std::vector<std::unique_ptr<tesseract::TessBaseAPI>> engines;
+    std::vector<tesseract::TessBaseAPI*> livres;
+    size_t inicializando = 0; // Init em andamento fora da trava; conta para maxEngines
+
+    tesseract::TessBaseAPI* adquirirEngine() {
+        std::unique_lock<std::mutex> lock(poolM);
+        for (;;) {
+            if (!livres.empty()) {
+                auto* e = livres.back();
+                livres.pop_back();
+                return e;
+            }
+            if (engines.size() + inicializando < cfg.maxEngines) break;
+            poolCv.wait(lock);
+        }
+        // Conta a vaga como em inicialização e roda o Init fora da trava: é a
+        // parte lenta. `engines` só recebe engines prontos, então nunca tem nulos.
+        inicializando++;
+        lock.unlock();
+
+        auto api = std::make_unique<tesseract::TessBaseAPI>();
+        const char* dataPath = cfg.tessdata.empty() ? nullptr : cfg.tessdata.c_str();
+        bool ok = api->Init(dataPath, cfg.idioma.c_str(), tesseract::OEM_DEFAULT) == 0;
+        if (ok) {
+            api->SetVariable("tessedit_char_whitelist", cfg.whitelist.c_str());
+            api->SetPageSegMode(tesseract::PSM_SINGLE_LINE);
+        }
+
+        lock.lock();
+        inicializando--;
+        if (!ok) {
+            poolCv.notify_one();
+            throw std::runtime_error("Falha ao inicializar Tesseract (idioma '" + cfg.idioma + "')");
+        }
+        engines.push_back(std::move(api));
+        return engines.back().get();
+    }
+
+    void devolverEngine(tesseract::TessBaseAPI* e) {
+        {
+            std::lock_guard<std::mutex> lock(poolM);
+            livres.push_back(e);
+        }
+        poolCv.notify_one();
+    }
+
+    struct EngineHandle {
+        TesseractOcrStrategy& dono;
+        tesseract::TessBaseAPI* api;
+        explicit EngineHandle(TesseractOcrStrategy& d) : dono(d), api(d.adquirirEngine()) {}
+        ~EngineHandle() { dono.devolverEngine(api); }
+        EngineHandle(const EngineHandle&) = delete;
+        EngineHandle& operator=(const EngineHandle&) = delete;
+    };
+#endif
+
+    // Distribui o lote entre até maxEngines threads; cada uma segura um engine do pool
+    template <typename Reconhece>
+    std::vector<double> emLote(size_t n, Reconhece reconhece) {
+        std::vector<double> valores(n, 0.0);
+        if (n == 0) return valores;
+        auto inicio = std::chrono::steady_clock::now();
+
+        std::atomic<size_t> proximo{0};
+        auto worker = [&]() {
+            for (size_t i = proximo++; i < n; i = proximo++) {
+                valores[i] = reconhece(i);
+            }
+        };
+        size_t numThreads = std::min(cfg.maxEngines, n);
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < numThreads; ++t) threads.emplace_back(worker);
+        worker(); // a thread chamadora também trabalha
+        for (auto& t : threads) t.join();
+
+        auto dur = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - inicio);
+        imagens += n;
+        lotes++;
+        microsEmLote += static_cast<uint64_t>(dur.count());
+        return valores;
+    }
+
+    double reconhecer(const std::string& caminhoImagem) {
+#ifdef USE_TESSERACT
+        if (fs::path(caminhoImagem).extension() != ".txt") {
+            double valor = 0.0;
+            if (reconhecerPix(pixRead(caminhoImagem.c_str()), valor)) return valor;
+        }
+#endif
+        return fallback.extrairLeitura(caminhoImagem);
+    }
+
+    double reconhecer(const Imagem& binaria, const std::string& caminhoOriginal) {
+#ifdef USE_TESSERACT
+        double valor = 0.0;
+        if (reconhecerPix(pixDeImagem(binaria), valor)) return valor;
+#else
+        (void)binaria;
+#endif
+        return fallback.extrairLeitura(caminhoOriginal);
+    }
+
+#ifdef USE_TESSERACT
+    // Copia uma imagem em cinza para um Pix de 8 bits; outros formatos ficam com nullptr
+    static Pix* pixDeImagem(const Imagem& img) {
+        if (img.vazia() || img.canais != 1) return nullptr;
+        Pix* pix = pixCreate(img.largura, img.altura, 8);
+        if (!pix) return nullptr;
+        l_uint32* dados = pixGetData(pix);
+        int wpl = pixGetWpl(pix);
+        for (int y = 0; y < img.altura; ++y) {
+            l_uint32* linha = dados + static_cast<size_t>(y) * wpl;
+            const uint8_t* origem = img.pixels.data() + static_cast<size_t>(y) * img.largura;
+            for (int x = 0; x < img.largura; ++x) SET_DATA_BYTE(linha, x, origem[x]);
+        }
+        return pix;
+    }
+
+    // Assume o Pix (destrói ao final); false se não houver imagem ou número no texto
+    bool reconhecerPix(Pix* pix, double& valor) {
+        if (!pix) return false;
+        std::string texto;
+        try {
+            EngineHandle h(*this);
+            h.api->SetImage(pix);
+            char* bruto = h.api->GetUTF8Text();
+            if (bruto) { texto = bruto; delete[] bruto; }
+            h.api->Clear();
+        } catch (const std::exception& e) {
+            LogManager::getInstance().log(std::string("OCR: ") + e.what());
+        }
+        pixDestroy(&pix);
+        return extrairPrimeiroNumero(texto, valor);
+    }
+#endif
+};
+
+// Decorator de OCR: guarda o resultado por imagem e só reprocessa quando o
+// arquivo muda (chave: caminho + tamanho + mtime). LRU limitada, dividida em
+// shards para que threads diferentes raramente disputem o mesmo mutex.
+class CachedOcrStrategy : public IOcrStrategy {
+public:
+    struct Estatisticas {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t remocoes = 0;
+        double taxaAcerto() const { return (hits + misses) ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+    };
+
+    explicit CachedOcrStrategy(std::shared_ptr<IOcrStrategy> origem, size_t capacidade = 4096)
+        : origem(std::move(origem)), capacidadePorShard(std::max<size_t>(1, capacidade / NUM_SHARDS)) {}
+
+    double extrairLeitura(const std::string& caminhoImagem) override {
+        fs::directory_entry entry(caminhoImagem); // um único stat para tamanho e mtime
+        if (!entry.is_regular_file()) return origem->extrairLeitura(caminhoImagem);
+        auto tamanho = entry.file_size();
+        auto mtime = entry.last_write_time();
+
+        double emCache;
+        if (consultar(caminhoImagem, tamanho, mtime, emCache)) {
+            hits++;
+            return emCache;
+        }
+
+        // OCR fora da trava: duas threads podem calcular a mesma imagem, mas ninguém espera o OCR alheio
+        misses++;
+        double valor = origem->extrairLeitura(caminhoImagem);
+        guardar(caminhoImagem, tamanho, mtime, valor);
+        return valor;
+    }
+
+    // Responde do cache o que puder e manda só as faltas, num único lote, para a origem
+    std::vector<double> extrairLeiturasEmLote(const std::vector<std::string>& caminhos) override {
+        std::vector<double> valores(caminhos.size(), 0.0);
+        std::vector<size_t> faltas;
+        std::vector<std::string> caminhosFaltantes;
+        struct Chave { bool arquivo; uintmax_t tamanho; fs::file_time_type mtime; };
+        std::vector<Chave> chaves;
+        for (size_t i = 0; i < caminhos.size(); ++i) {
+            fs::directory_entry entry(caminhos[i]);
+            if (entry.is_regular_file()) {
+                auto tamanho = entry.file_size();
+                auto mtime = entry.last_write_time();
+                if (consultar(caminhos[i], tamanho, mtime, valores[i])) {
+                    hits++;
+                    continue;
+                }
+                chaves.push_back({true, tamanho, mtime});
+            } else {
+                chaves.push_back({false, 0, {}});
+            }
+            misses++;
+            faltas.push_back(i);
+            caminhosFaltantes.push_back(caminhos[i]);
+        }
+        if (faltas.empty()) return valores;
+
+        auto calculados = origem->extrairLeiturasEmLote(caminhosFaltantes);
+        for (size_t k = 0; k < faltas.size(); ++k) {
+            valores[faltas[k]] = calculados[k];
+            if (chaves[k].arquivo) guardar(caminhosFaltantes[k], chaves[k].tamanho, chaves[k].mtime, calculados[k]);
+        }
+        return valores;
+    }
+
+    Estatisticas estatisticas() const {
+        return {hits.load(), misses.load(), remocoes.load()};
+    }
+
+private:
+    struct Entrada {
+        std::string caminho;
+        uintmax_t tamanho;
+        fs::file_time_type mtime;
+        double valor;
+    };
+    struct Shard {
+        std::mutex m;
+        std::list<Entrada> lru; // mais recente na frente
+        std::unordered_map<std::string, std::list<Entrada>::iterator> indice;
+    };
+    static constexpr size_t NUM_SHARDS = 16;
+
+    std::shared_ptr<IOcrStrategy> origem;
+    size_t capacidadePorShard;
+    std::array<Shard, NUM_SHARDS> shards;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> remocoes{0};
+
+    Shard& shardDe(const std::string& caminho) {
+        return shards[std::hash<std::string>{}(caminho) % NUM_SHARDS];
+    }
+
+    bool consultar(const std::string& caminhoImagem, uintmax_t tamanho, fs::file_time_type mtime, double& valor) {
+        Shard& shard = shardDe(caminhoImagem);
+        std::lock_guard<std::mutex> lock(shard.m);
+        auto it = shard.indice.find(caminhoImagem);
+        if (it == shard.indice.end() || it->second->tamanho != tamanho || it->second->mtime != mtime) return false;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        valor = it->second->valor;
+        return true;
+    }
+
+    void guardar(const std::string& caminhoImagem, uintmax_t tamanho, fs::file_time_type mtime, double valor) {
+        Shard& shard = shardDe(caminhoImagem);
+        std::lock_guard<std::mutex> lock(shard.m);
+        auto it = shard.indice.find(caminhoImagem);
+        if (it != shard.indice.end()) {
+            *it->second = Entrada{caminhoImagem, tamanho, mtime, valor};
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        } else {
+            shard.lru.push_front(Entrada{caminhoImagem, tamanho, mtime, valor});
+            shard.indice[caminhoImagem] = shard.lru.begin();
+            if (shard.lru.size() > capacidadePorShard) {
+                shard.indice.erase(shard.lru.back().caminho);
+                shard.lru.pop_back();
+                remocoes++;
+            }
+        }
+    }
+};
+
+// OCR sem biblioteca externa para mostradores de fonte fixa: binariza a imagem,
+// segmenta as rodas de dígitos e classifica cada uma por correlação com os
+// templates aprendidos. Abaixo da confiança mínima (ou sem imagem decodificável)
+// delega ao fallback, se houver.
+class TemplateOcrStrategy : public IOcrStrategy {
+public:
+    explicit TemplateOcrStrategy(std::shared_ptr<const ReconhecedorDigitos> modelo,
+                                 std::shared_ptr<IOcrStrategy> fallback = nullptr,
+                                 ConfigLimiar limiar = ConfigLimiar{}, float confiancaMinima = 0.5f)
+        : modelo(std::move(modelo)), fallback(std::move(fallback)), limiar(limiar), confiancaMinima(confiancaMinima) {}
+
+    double extrairLeitura(const std::string& caminhoImagem) override {
+        Imagem img;
+        double valor = 0.0;
+        if (fs::path(caminhoImagem).extension() != ".txt" && decodificarImagem(caminhoImagem, img) &&
+            classificar(preprocessarImagem(img, RegiaoInteresse{}, limiar), valor)) {
+            return valor;
+        }
+        return fallback ? fallback->extrairLeitura(caminhoImagem) : 0.0;
+    }
+
+    // A imagem já chega binarizada: classifica direto, sem novo limiar
+    double extrairLeituraPreprocessada(const Imagem& binaria, const std::string& caminhoOriginal) override {
+        double valor = 0.0;
+        if (classificar(binaria, valor)) return valor;
+        return fallback ? fallback->extrairLeituraPreprocessada(binaria, caminhoOriginal) : 0.0;
+    }
+
+private:
+    std::shared_ptr<const ReconhecedorDigitos> modelo;
+    std::shared_ptr<IOcrStrategy> fallback;
+    ConfigLimiar limiar;
+    float confiancaMinima;
+
+    bool classificar(const Imagem& binaria, double& valor) const {
+        auto r = modelo->reconhecer(binaria);
+        return r.confianca >= confiancaMinima && r.texto.find('?') == std::string::npos &&
+               extrairPrimeiroNumero(r.texto, valor);
+    }
+};
+
+// Decorator de OCR que entrega à estratégia de origem só a região dos dígitos:
+// decodifica, recorta a ROI do hidrômetro (chave = nome da pasta do simulador,
+// "*" = padrão), converte para cinza e aplica limiar adaptativo com kernels
+// SIMD. A imagem pronta segue em memória (extrairLeituraPreprocessada), junto
+// do caminho original para quem lê o valor pelo nome. Formatos que não
+// decodificam (.txt) passam direto.
+class PreprocessamentoOcrStrategy : public IOcrStrategy {
+public:
+    PreprocessamentoOcrStrategy(std::shared_ptr<IOcrStrategy> origem,
+                                std::map<std::string, RegiaoInteresse> regioes,
+                                ConfigLimiar limiar = ConfigLimiar{})
+        : origem(std::move(origem)), regioes(std::move(regioes)), limiar(limiar) {}
+
+    double extrairLeitura(const std::string& caminhoImagem) override {
+        Imagem pronta;
+        if (!preparar(caminhoImagem, pronta)) return origem->extrairLeitura(caminhoImagem);
+        return origem->extrairLeituraPreprocessada(pronta, caminhoImagem);
+    }
+
+    std::vector<double> extrairLeiturasEmLote(const std::vector<std::string>& caminhos) override {
+        std::vector<double> valores(caminhos.size(), 0.0);
+        std::vector<size_t> idxProntas, idxDiretas;
+        std::vector<Imagem> prontas;
+        std::vector<std::string> caminhosProntas, caminhosDiretos;
+        for (size_t i = 0; i < caminhos.size(); ++i) {
+            Imagem pronta;
+            if (preparar(caminhos[i], pronta)) {
+                idxProntas.push_back(i);
+                prontas.push_back(std::move(pronta));
+                caminhosProntas.push_back(caminhos[i]);
+            } else {
+                idxDiretas.push_back(i);
+                caminhosDiretos.push_back(caminhos[i]);
+            }
+        }
+        if (!prontas.empty()) {
+            auto v = origem->extrairLeiturasPreprocessadasEmLote(prontas, caminhosProntas);
+            for (size_t k = 0; k < idxProntas.size(); ++k) valores[idxProntas[k]] = v[k];
+        }
+        if (!caminhosDiretos.empty()) {
+            auto v = origem->extrairLeiturasEmLote(caminhosDiretos);
+            for (size_t k = 0; k < idxDiretas.size(); ++k) valores[idxDiretas[k]] = v[k];
+        }
+        return valores;
+    }
+
+private:
+    std::shared_ptr<IOcrStrategy> origem;
+    std::map<std::string, RegiaoInteresse> regioes; // somente leitura após a construção
+    ConfigLimiar limiar;
+
+    RegiaoInteresse regiaoDe(const std::string& medidor) const {
+        auto it = regioes.find(medidor);
+        if (it == regioes.end()) it = regioes.find("*");
+        return it != regioes.end() ? it->second : RegiaoInteresse{};
+    }
+
+    bool preparar(const std::string& caminhoImagem, Imagem& pronta) const {
+        fs::path p(caminhoImagem);
+        if (p.extension() == ".txt") return false;
+        Imagem img;
+        if (!decodificarImagem(caminhoImagem, img)) return false;
+        pronta = preprocessarImagem(img, regiaoDe(p.parent_path().filename().string()), limiar);
+        return true;
     }
 };
 
@@ -160,6 +844,70 @@ public:
     virtual double obterConsumo() = 0;
 };
 
+struct LeituraCiclo {
+    double valor = 0.0;
+    std::string caminhoImagem;
+};
+
+// Leituras de um ciclo de monitoramento: cada hidrômetro físico é lido
+// (varredura + OCR) uma única vez, por quem pedir primeiro; as demais folhas do
+// mesmo medidor (usuários diferentes num condomínio, p.ex.) reaproveitam o
+// valor, esperando se a leitura ainda estiver em andamento.
+class TabelaLeiturasCiclo {
+public:
+    struct Estatisticas {
+        uint64_t leituras = 0;    // leituras físicas feitas
+        uint64_t evitadas = 0;    // pedidos atendidos pela tabela
+    };
+
+    explicit TabelaLeiturasCiclo(std::chrono::milliseconds prazoEspera = std::chrono::seconds(10))
+        : prazoEspera(prazoEspera) {}
+
+    LeituraCiclo obter(const std::string& idSHA, const std::function<LeituraCiclo()>& ler) {
+        std::shared_future<LeituraCiclo> futuro;
+        std::promise<LeituraCiclo> promessa;
+        bool souLeitor = false;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            auto it = entradas.find(idSHA);
+            if (it == entradas.end()) {
+                futuro = promessa.get_future().share();
+                entradas.emplace(idSHA, futuro);
+                souLeitor = true;
+            } else {
+                futuro = it->second;
+            }
+        }
+
+        if (souLeitor) {
+            leituras++;
+            try {
+                promessa.set_value(ler());
+            } catch (...) {
+                promessa.set_exception(std::current_exception());
+            }
+        } else {
+            evitadas++;
+            // O leitor já está executando ler(): basta esperar, não há o que ajudar
+            if (futuro.wait_for(prazoEspera) != std::future_status::ready) {
+                throw std::runtime_error("Leitura de " + idSHA + " nao terminou no prazo");
+            }
+        }
+        return futuro.get(); // relança a falha do leitor para todas as folhas do medidor
+    }
+
+    Estatisticas estatisticas() const {
+        return {leituras.load(), evitadas.load()};
+    }
+
+private:
+    std::chrono::milliseconds prazoEspera;
+    std::mutex m;
+    std::unordered_map<std::string, std::shared_future<LeituraCiclo>> entradas;
+    std::atomic<uint64_t> leituras{0};
+    std::atomic<uint64_t> evitadas{0};
+};
+
 class HidrometroLeaf : public ConsumoComponent {
 private:
     std::string idSHA;
@@ -167,52 +915,106 @@ private:
     std::shared_ptr<IOcrStrategy> ocrStrategy;
     std::shared_ptr<IHistoricoRepository> historicoRepo;
     int userId;
+    std::shared_ptr<TabelaLeiturasCiclo> tabela; // opcional: compartilha a leitura no ciclo
 public:
     HidrometroLeaf(const std::string& sha, std::shared_ptr<ISimuladorAdapter> adp,
-                   std::shared_ptr<IOcrStrategy> ocr, std::shared_ptr<IHistoricoRepository> repo, int uid)
-        : idSHA(sha), adapter(adp), ocrStrategy(ocr), historicoRepo(repo), userId(uid) {}
+                   std::shared_ptr<IOcrStrategy> ocr, std::shared_ptr<IHistoricoRepository> repo, int uid,
+                   std::shared_ptr<TabelaLeiturasCiclo> tabela = nullptr)
+        : idSHA(sha), adapter(adp), ocrStrategy(ocr), historicoRepo(repo), userId(uid), tabela(std::move(tabela)) {}
 
     double obterConsumo() override {
         try {
-            std::string caminhoImagem = adapter->obterCaminhoArquivoImagem();
-            double valor = ocrStrategy->extrairLeitura(caminhoImagem);
+            auto ler = [this]() {
+                LeituraCiclo l;
+                l.caminhoImagem = adapter->obterCaminhoArquivoImagem();
+                l.valor = ocrStrategy->extrairLeitura(l.caminhoImagem);
+                return l;
+            };
+            LeituraCiclo lida = tabela ? tabela->obter(idSHA, ler) : ler();
+            // O histórico é por usuário: cada dono registra sua linha, sem nova leitura
             if (historicoRepo) {
                 Leitura leitura;
                 leitura.userId = userId;
                 leitura.idSHA = idSHA;
-                leitura.data = nowIso();
-                leitura.valor = valor;
-                leitura.caminhoImagem = caminhoImagem;
+                leitura.data = agoraEpochMs();
+                leitura.valor = lida.valor;
+                leitura.caminhoImagem = lida.caminhoImagem;
                 historicoRepo->salvarLeitura(leitura);
             }
-            return valor;
+            return lida.valor;
         } catch (const std::exception& e) {
-            std::cout << "\n[ERRO FATAL NO SENSOR] Ocorreu uma excecao: " << e.what() << std::endl;
+            // Folhas rodam em paralelo: o logger serializa a saída
+            LogManager::getInstance().log("[ERRO NO SENSOR] " + idSHA + ": " + e.what());
             return 0.0;
         }
     }
-private:
-    static std::string nowIso() {
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        std::ostringstream ss;
-        ss << std::put_time(std::gmtime(&time), "%Y-%m-%dT%H:%M:%SZ");
-        return ss.str();
-    }
 };
 
+// Avalia os componentes em paralelo no PoolTarefas do processo, todos como
+// tarefas de um GrupoTarefas: a espera executa os filhos que ainda não
+// começaram, então composites aninhados não travam o pool. Componente que
+// lança exceção ou não termina até o prazo fica fora da soma.
 class UsuarioComposite : public ConsumoComponent {
-private:
-    std::vector<std::shared_ptr<ConsumoComponent>> componentes;
 public:
+    struct Resumo {
+        int concluidos = 0;
+        int falhas = 0;
+        int expirados = 0;
+    };
+
+    explicit UsuarioComposite(std::chrono::milliseconds prazoPorAvaliacao = std::chrono::seconds(10))
+        : prazoPorAvaliacao(prazoPorAvaliacao) {}
+
     void adicionarComponente(std::shared_ptr<ConsumoComponent> comp) {
         componentes.push_back(comp);
     }
+
     double obterConsumo() override {
+        Resumo r;
         double total = 0.0;
-        for (auto& comp : componentes) total += comp->obterConsumo();
+        if (componentes.empty()) return total;
+
+        GrupoTarefas grupo(PoolTarefas::getInstance());
+        auto prazo = std::chrono::steady_clock::now() + prazoPorAvaliacao;
+        std::vector<std::future<double>> futuros;
+        futuros.reserve(componentes.size());
+        for (const auto& comp : componentes) {
+            // a tarefa mantém o componente vivo mesmo se expirar
+            futuros.push_back(grupo.submeter([comp]() { return comp->obterConsumo(); }));
+        }
+
+        for (auto& f : futuros) {
+            if (!grupo.aguardar(f, prazo)) {
+                r.expirados++;
+                continue;
+            }
+            try {
+                total += f.get();
+                r.concluidos++;
+            } catch (const std::exception& e) {
+                r.falhas++;
+                LogManager::getInstance().log(std::string("Componente falhou: ") + e.what());
+            }
+        }
+        if (r.expirados) {
+            LogManager::getInstance().log(std::to_string(r.expirados) + " componente(s) sem resposta no prazo; fora da soma");
+        }
+
+        std::lock_guard<std::mutex> lock(resumoM);
+        ultimo = r;
         return total;
     }
+
+    Resumo ultimoResumo() const {
+        std::lock_guard<std::mutex> lock(resumoM);
+        return ultimo;
+    }
+
+private:
+    std::vector<std::shared_ptr<ConsumoComponent>> componentes;
+    std::chrono::milliseconds prazoPorAvaliacao;
+    mutable std::mutex resumoM;
+    Resumo ultimo;
 };
 
 // ==================== STRATEGIES & OBSERVER ====================
@@ -233,12 +1035,19 @@ public:
     std::string obterMensagem(double consumo) override { return "Consumo " + std::to_string(consumo) + " > Limite " + std::to_string(limite); }
 };
 
+// Com uma JanelaMovel a média sai da memória em O(1); sem ela, consulta o repositório
 class RegraMediaMovel : public IStrategiaAnalise {
     int janela;
     double mult;
+    std::shared_ptr<JanelaMovel> recentes;
 public:
-    RegraMediaMovel(int j, double m = 1.2) : janela(j), mult(m) {}
+    RegraMediaMovel(int j, double m = 1.2, std::shared_ptr<JanelaMovel> recentes = nullptr)
+        : janela(j), mult(m), recentes(std::move(recentes)) {}
     bool analisar(double consumo, std::shared_ptr<IHistoricoRepository> repo, int userId) override {
+        if (recentes) {
+            double media = 0.0;
+            return recentes->media(media) && consumo > (media * mult);
+        }
         if (!repo) return false;
         auto leituras = repo->listarLeiturasPorUsuario(userId, janela);
         if (leituras.empty()) return false;
@@ -261,67 +1070,73 @@ public:
 
 // ==================== ALERT SERVICE ====================
 class AlertaService {
-    std::vector<std::shared_ptr<IEventoObserver>> observadores;
-    std::vector<std::pair<int, std::shared_ptr<IStrategiaAnalise>>> regras;
+    // Observadores viram canais do despachante: verificarAlertas só enfileira
+    DespachanteNotificacoes despachante;
+    // Regras indexadas por usuário e publicadas como snapshot imutável (RCU):
+    // verificarAlertas pega o ponteiro atual sem trava e só vê as regras do
+    // usuário; adicionarRegra refaz apenas a lista do usuário e republica.
+    // Cada regra leva o id persistido (salvarRegra), que é a chave do cooldown.
+    struct RegraAtiva {
+        int id;
+        std::shared_ptr<IStrategiaAnalise> strategy;
+    };
+    using RegrasUsuario = std::vector<RegraAtiva>;
+    using IndiceRegras = std::unordered_map<int, std::shared_ptr<const RegrasUsuario>>;
+    std::shared_ptr<const IndiceRegras> regrasPorUsuario = std::make_shared<const IndiceRegras>();
     std::shared_ptr<IHistoricoRepository> historicoRepo;
-    mutable std::shared_mutex obsM, regrasM;
+    std::mutex regrasM; // serializa apenas os escritores do índice
 
-    // Mapa para controlar o Cooldown (Hora do último envio por usuário)
-    std::map<int, std::chrono::steady_clock::time_point> ultimoEnvio;
+    // Cooldown/dedup/escalonamento por (usuário, regra), seguro entre threads
+    TabelaCooldown cooldowns;
 
 public:
     void setHistoricoRepository(std::shared_ptr<IHistoricoRepository> repo) { historicoRepo = repo; }
+    void setPoliticaAlerta(const PoliticaAlerta& politica) { cooldowns.definirPolitica(politica); }
+    TabelaCooldown::Estatisticas estatisticasCooldown() const { return cooldowns.estatisticas(); }
+    void esquecerUsuario(int userId) { cooldowns.esquecer(userId); }
     
     void registrarObservador(std::shared_ptr<IEventoObserver> obs) {
-        std::lock_guard<std::shared_mutex> lock(obsM);
-        observadores.push_back(obs);
+        despachante.adicionarCanal(std::move(obs));
     }
+    DespachanteNotificacoes::Estatisticas estatisticasNotificacoes() const { return despachante.estatisticas(); }
+    void pararNotificacoes() { despachante.parar(); }
     
-    void adicionarRegra(int userId, std::shared_ptr<IStrategiaAnalise> st) {
-        std::lock_guard<std::shared_mutex> lock(regrasM);
-        regras.push_back({userId, st});
+    void adicionarRegra(int userId, int regraId, std::shared_ptr<IStrategiaAnalise> st) {
+        std::lock_guard<std::mutex> lock(regrasM);
+        auto atual = std::atomic_load(&regrasPorUsuario);
+        auto lista = std::make_shared<RegrasUsuario>();
+        auto it = atual->find(userId);
+        if (it != atual->end()) *lista = *it->second;
+        lista->push_back(RegraAtiva{regraId, std::move(st)});
+        // Copia só os ponteiros das listas; as dos outros usuários são compartilhadas
+        auto novo = std::make_shared<IndiceRegras>(*atual);
+        (*novo)[userId] = std::move(lista);
+        std::atomic_store(&regrasPorUsuario, std::shared_ptr<const IndiceRegras>(std::move(novo)));
     }
 
     void verificarAlertas(int userId, const std::string& nomeUser, double consumo) {
-        std::shared_lock<std::shared_mutex> lockRegras(regrasM);
-        auto regrasLocais = regras; 
-        lockRegras.unlock();
-
-        // 2. Itera sobre as regras
-        for (const auto& [uid, strategy] : regrasLocais) {
-            if (uid == userId) {
-                bool disparou = strategy->analisar(consumo, historicoRepo, userId);
+        auto indice = std::atomic_load(&regrasPorUsuario);
+        auto it = indice->find(userId);
+        if (it == indice->end()) return;
+
+        // 2. Itera sobre as regras do usuário
+        for (const auto& [regraId, strategy] : *it->second) {
+            bool disparou = strategy->analisar(consumo, historicoRepo, userId);
+            
+            if (disparou) {
+                auto decisao = cooldowns.avaliar(userId, regraId, consumo);
+                if (decisao == DecisaoAlerta::SUPRIMIR_COOLDOWN || decisao == DecisaoAlerta::SUPRIMIR_DUPLICADO) continue;
+
+                std::string mensagem = strategy->obterMensagem(consumo);
+                if (decisao == DecisaoAlerta::ESCALAR) mensagem = "[ESCALADO] " + mensagem;
+                DadosAlerta dados{userId, nomeUser, consumo, mensagem, agoraEpochMs()};
                 
-                if (disparou) {
-                    auto agora = std::chrono::steady_clock::now();
-                    
-                    if (ultimoEnvio.count(userId)) {
-                        auto tempoPassado = std::chrono::duration_cast<std::chrono::seconds>(agora - ultimoEnvio[userId]).count();
-                        if (tempoPassado < 120) {
-                            continue; 
-                        }
-                    }
-                    
-                    // Atualiza o relógio para agora
-                    ultimoEnvio[userId] = agora;
-                    // ==========================
-
-                    auto tempoAtual = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-                    std::stringstream ss;
-                    // Formato: Dia/Mês/Ano Hora:Minuto:Segundo
-                    ss << std::put_time(std::localtime(&tempoAtual), "%d/%m/%Y %H:%M:%S");
-                    std::string dataFormatada = ss.str();
-                    
-                    DadosAlerta dados{userId, nomeUser, consumo, strategy->obterMensagem(consumo), dataFormatada};
-                    
-                    if (historicoRepo) {
-                        AlertaRecord rec{0, userId, consumo, dados.mensagem, dados.data};
-                        historicoRepo->salvarAlerta(rec);
-                    }
-                    
-                    std::shared_lock<std::shared_mutex> lockObs(obsM);
-                    for (auto& obs : observadores) obs->atualizar(dados);
+                if (historicoRepo) {
+                    AlertaRecord rec{0, userId, consumo, dados.mensagem, dados.data};
+                    historicoRepo->salvarAlerta(rec);
                 }
+
+                despachante.publicar(dados);
             }
         }
     }
@@ -336,10 +1151,42 @@ private:
     std::shared_ptr<IUsuarioRepository> usuarioRepo;
     std::shared_ptr<IHistoricoRepository> historicoRepo;
     AlertaService alertaService;
-    std::map<std::string, std::shared_ptr<ISimuladorAdapter>> simuladoresById;
+    // Registro de simuladores publicado como snapshot imutável (RCU): leitores
+    // pegam o ponteiro atual sem trava; escritores copiam, alteram e republicam.
+    using RegistroSimuladores = std::map<std::string, std::shared_ptr<ISimuladorAdapter>>;
+    std::shared_ptr<const RegistroSimuladores> simuladoresById = std::make_shared<const RegistroSimuladores>();
+    std::mutex registroM; // serializa apenas os escritores do registro
     std::vector<std::shared_ptr<ISimuladorAdapter>> simuladoresFallback;
     std::shared_ptr<IOcrStrategy> ocrStrategy;
     mutable std::shared_mutex acessoM;
+    int ultimoIdRegraLocal = 0; // regras sem historicoRepo; protegido por acessoM
+    std::atomic<uint64_t> leiturasFisicas{0};
+    std::atomic<uint64_t> leiturasEvitadas{0};
+    // Janelas das regras de média móvel, alimentadas pelo historicoRepo decorado
+    std::shared_ptr<JanelasConsumo> janelas = std::make_shared<JanelasConsumo>();
+
+    // Strategy do tipo pedido (nullptr se desconhecido); `extra` sai com o que vai para TB_REGRAS
+    std::shared_ptr<IStrategiaAnalise> criarRegra(int userId, const std::string& tipo, double valor, int& extra) {
+        if (tipo == "limite") return std::make_shared<RegraLimiteFixo>(valor);
+        if (tipo == "media") {
+            extra = std::max(1, (int)valor);
+            auto recentes = janelas->obterJanela(userId, (size_t)extra, historicoRepo.get());
+            return std::make_shared<RegraMediaMovel>(extra, 1.2, recentes);
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<const RegistroSimuladores> snapshotSimuladores() const {
+        return std::atomic_load(&simuladoresById);
+    }
+
+    template <typename Alteracao>
+    void alterarRegistro(Alteracao alteracao) {
+        std::lock_guard<std::mutex> lock(registroM);
+        auto novo = std::make_shared<RegistroSimuladores>(*snapshotSimuladores());
+        alteracao(*novo);
+        std::atomic_store(&simuladoresById, std::shared_ptr<const RegistroSimuladores>(std::move(novo)));
+    }
 
     FachadaSMH() : ocrStrategy(std::make_shared<FilenameOcrStrategy>()) {
         alertaService.setHistoricoRepository(historicoRepo);
@@ -358,8 +1205,8 @@ public:
     }
     void setHistoricoRepository(std::shared_ptr<IHistoricoRepository> repo) {
         std::lock_guard<std::shared_mutex> lock(acessoM);
-        historicoRepo = repo;
-        alertaService.setHistoricoRepository(repo);
+        historicoRepo = repo ? std::make_shared<HistoricoRepositoryJanelas>(repo, janelas) : repo;
+        alertaService.setHistoricoRepository(historicoRepo);
     }
     void setOcrStrategy(std::shared_ptr<IOcrStrategy> st) {
         std::lock_guard<std::shared_mutex> lock(acessoM);
@@ -389,6 +1236,7 @@ public:
         std::shared_lock<std::shared_mutex> lock(acessoM);
         if (!token.valido() || token.perfil != Perfil::ADMIN) throw std::runtime_error("Acesso Negado");
         if (usuarioRepo) usuarioRepo->deletar(id);
+        alertaService.esquecerUsuario(id);
     }
 
     void vincularHidrometro(int uid, const std::string& sha, const Token& token) {
@@ -397,7 +1245,8 @@ public:
         // 1. Validação de Permissão
         if (!token.valido()) throw std::runtime_error("Acesso Negado");
 
-        if (simuladoresById.find(sha) == simuladoresById.end()) {
+        auto simuladores = snapshotSimuladores();
+        if (simuladores->find(sha) == simuladores->end()) {
             throw std::runtime_error("Erro: O Hidrometro '" + sha + "' nao foi detectado na rede/pasta.");
         }
 
@@ -424,50 +1273,115 @@ public:
         }
     }
 
+    // Imagem mais recente do simulador, sem OCR (lança se estiver offline)
+    std::string obterCaminhoImagemAtual(const std::string& idSHA) {
+        auto simuladores = snapshotSimuladores();
+        auto it = simuladores->find(idSHA);
+        if (it == simuladores->end()) throw std::runtime_error("Simulador desconectado (Offline): " + idSHA);
+        return it->second->obterCaminhoArquivoImagem();
+    }
+
     // Retorna a lista de todos os SHAs que o sistema detectou fisicamente
     std::vector<std::string> listarSimuladoresDetectados() {
-        std::shared_lock<std::shared_mutex> lock(acessoM);
         std::vector<std::string> lista;
-        for (const auto& pair : simuladoresById) {
+        for (const auto& pair : *snapshotSimuladores()) {
             lista.push_back(pair.first);
         }
         return lista;
     }
 
     void conectarSimulador(const std::map<std::string, std::string>& params, const Token& token) {
-        std::lock_guard<std::shared_mutex> lock(acessoM);
+        if (!token.valido() || token.perfil != Perfil::ADMIN) throw std::runtime_error("Acesso Negado");
+        // O adapter (que pode varrer a pasta) é criado fora de qualquer trava
         auto adapter = SimuladorFactory::criarAdapter(params);
         auto idSHA = params.find("idSHA");
         if (idSHA != params.end()) {
-            simuladoresById[idSHA->second] = adapter;
+            alterarRegistro([&](RegistroSimuladores& r) { r[idSHA->second] = adapter; });
         }
     }
 
+    void desconectarSimulador(const std::string& idSHA, const Token& token) {
+        if (!token.valido() || token.perfil != Perfil::ADMIN) throw std::runtime_error("Acesso Negado");
+        if (!snapshotSimuladores()->count(idSHA)) return;
+        alterarRegistro([&](RegistroSimuladores& r) { r.erase(idSHA); });
+    }
+
     double obterLeituraAtual(const std::string& idSHA, const Token& token) {
-        std::shared_lock<std::shared_mutex> lock(acessoM);
         if (!token.valido()) throw std::runtime_error("Acesso negado");
 
-        auto it = simuladoresById.find(idSHA);
-        if (it == simuladoresById.end()) throw std::runtime_error("Simulador desconectado (Offline): " + idSHA);
-        
-        return ocrStrategy->extrairLeitura(it->second->obterCaminhoArquivoImagem());
+        auto simuladores = snapshotSimuladores();
+        auto it = simuladores->find(idSHA);
+        if (it == simuladores->end()) throw std::runtime_error("Simulador desconectado (Offline): " + idSHA);
+
+        std::shared_ptr<IOcrStrategy> ocr;
+        {
+            std::shared_lock<std::shared_mutex> lock(acessoM);
+            ocr = ocrStrategy;
+        }
+        // Varredura e OCR sem nenhuma trava da fachada
+        return ocr->extrairLeitura(it->second->obterCaminhoArquivoImagem());
     }
 
     void monitorarConsumo(int userId) {
-        std::shared_lock<std::shared_mutex> lock(acessoM);
-        if (!usuarioRepo) return;
-        
-        // Buscar o usuário para pegar o nome
-        auto userOpt = usuarioRepo->buscarPorId(userId);
+        std::optional<Usuario> userOpt;
+        {
+            std::shared_lock<std::shared_mutex> lock(acessoM);
+            if (!usuarioRepo) return;
+            // Buscar o usuário para pegar o nome
+            userOpt = usuarioRepo->buscarPorId(userId);
+        }
         if (!userOpt.has_value()) return; // Se não achar user, sai
-        auto user = *userOpt;             // Pega o objeto Usuario
+        monitorarConsumo(*userOpt);
+    }
+
+    // Monitora vários usuários como um ciclo: todos em paralelo no PoolTarefas,
+    // compartilhando uma TabelaLeiturasCiclo para que hidrômetro ligado a mais
+    // de um usuário seja lido uma vez só.
+    void monitorarUsuarios(const std::vector<Usuario>& usuarios) {
+        if (usuarios.empty()) return;
+        auto tabela = std::make_shared<TabelaLeiturasCiclo>();
+        GrupoTarefas grupo(PoolTarefas::getInstance());
+        std::vector<std::future<void>> pendentes;
+        for (const Usuario& u : usuarios) {
+            pendentes.push_back(grupo.submeter([this, &u, tabela]() { monitorarConsumo(u, tabela); }));
+        }
+        for (auto& f : pendentes) {
+            // Sem prazo: as tarefas referenciam `usuarios`, que precisa viver até o fim delas
+            grupo.aguardar(f, std::chrono::steady_clock::time_point::max());
+            try {
+                f.get();
+            } catch (const std::exception& e) {
+                LogManager::getInstance().log(std::string("Falha ao monitorar usuario: ") + e.what());
+            }
+        }
+        auto est = tabela->estatisticas();
+        leiturasFisicas += est.leituras;
+        leiturasEvitadas += est.evitadas;
+    }
+
+    TabelaLeiturasCiclo::Estatisticas estatisticasLeituras() const {
+        return {leiturasFisicas.load(), leiturasEvitadas.load()};
+    }
+
+    // Monitora a partir de um snapshot já carregado (ex: listarTodosUsuarios),
+    // sem consultar o repositório de novo para cada usuário.
+    void monitorarConsumo(const Usuario& user, std::shared_ptr<TabelaLeiturasCiclo> tabela = nullptr) {
+        int userId = user.id;
+        std::shared_ptr<IOcrStrategy> ocr;
+        std::shared_ptr<IHistoricoRepository> historico;
+        {
+            std::shared_lock<std::shared_mutex> lock(acessoM);
+            ocr = ocrStrategy;
+            historico = historicoRepo;
+        }
+        auto simuladores = snapshotSimuladores();
 
         auto composite = std::make_shared<UsuarioComposite>();
         for (const auto& sha : user.hidrometros) {
-            auto it = simuladoresById.find(sha);
-            if (it != simuladoresById.end()) {
+            auto it = simuladores->find(sha);
+            if (it != simuladores->end()) {
                 composite->adicionarComponente(std::make_shared<HidrometroLeaf>(
-                    sha, it->second, ocrStrategy, historicoRepo, userId));
+                    sha, it->second, ocr, historico, userId, tabela));
             }
         }
         double consumo = composite->obterConsumo();
@@ -478,17 +1392,31 @@ public:
 
     void configurarRegraAlerta(int userId, const std::string& tipo, double valor) {
         std::lock_guard<std::shared_mutex> lock(acessoM);
-        std::shared_ptr<IStrategiaAnalise> st;
         int extra = 0;
-        if (tipo == "limite") st = std::make_shared<RegraLimiteFixo>(valor);
-        else if (tipo == "media") { st = std::make_shared<RegraMediaMovel>((int)valor); extra = (int)valor; }
+        auto st = criarRegra(userId, tipo, valor, extra);
         
         if (st) {
-            alertaService.adicionarRegra(userId, st);
-            if (historicoRepo) historicoRepo->salvarRegra(userId, tipo, valor, extra);
+            // Sem repositório a regra não persiste: ids locais negativos não colidem com os do banco
+            int regraId = historicoRepo ? historicoRepo->salvarRegra(userId, tipo, valor, extra) : --ultimoIdRegraLocal;
+            alertaService.adicionarRegra(userId, regraId, st);
         }
     }
+
+    // Reativa uma regra já persistida com o id do banco, sem gravar de novo:
+    // o id é a chave do cooldown, então ele se mantém entre reinícios
+    void restaurarRegraAlerta(int userId, int regraId, const std::string& tipo, double valor) {
+        std::lock_guard<std::shared_mutex> lock(acessoM);
+        int extra = 0;
+        auto st = criarRegra(userId, tipo, valor, extra);
+        if (st) alertaService.adicionarRegra(userId, regraId, st);
+    }
     
+    void configurarPoliticaAlerta(const PoliticaAlerta& politica) { alertaService.setPoliticaAlerta(politica); }
+    TabelaCooldown::Estatisticas estatisticasAlertas() const { return alertaService.estatisticasCooldown(); }
+    DespachanteNotificacoes::Estatisticas estatisticasNotificacoes() const { return alertaService.estatisticasNotificacoes(); }
+    // Entrega o que está na fila antes de sair
+    void pararNotificacoes() { alertaService.pararNotificacoes(); }
+
     void registrarObservador(std::shared_ptr<IEventoObserver> obs) {
         std::lock_guard<std::shared_mutex> lock(acessoM);
         alertaService.registrarObservador(obs);
@@ -510,6 +1438,9 @@ void exibirMenu() {
     std::cout << "4. [MONITOR] Ver SHAs Ativos e Status\n";
     std::cout << "5. [ADMIN] Vincular Hidrometro a Usuario\n";
     std::cout << "6. [ADMIN] Desvincular Hidrometro\n"; // <--- NOVO
+    std::cout << "7. [DIAG] Benchmark Preprocessamento (escalar x SIMD)\n";
+    std::cout << "8. [DIAG] Treinar/Avaliar OCR por Templates\n";
+    std::cout << "9. [DIAG] Estresse da Tabela de Cooldown de Alertas\n";
     std::cout << "0. Sair\n";
     std::cout << "Escolha uma opcao: ";
 }
@@ -521,6 +1452,7 @@ struct SmtpConfig {
     std::string user;
     std::string pass;
     SmtpEmailService::SecureMode secure = SmtpEmailService::SecureMode::NONE;
+    std::chrono::seconds janelaResumo{0}; // 0 = um e-mail por alerta
 };
 
 // static SmtpConfig carregarSmtpConfig() {
@@ -544,6 +1476,766 @@ static std::string trim(const std::string& str) {
     return str.substr(first, (last - first + 1));
 }
 
+// ==================== DESCOBERTA DE SIMULADORES ====================
+
+// Lê as regiões de interesse do OCR: "<pasta do simulador|*> x y largura
+// altura" por linha, '#' comenta. Arquivo ausente = nenhuma região.
+static std::map<std::string, RegiaoInteresse> carregarRegioesInteresse(const std::string& arquivo) {
+    std::map<std::string, RegiaoInteresse> regioes;
+    std::ifstream file(arquivo);
+    if (!file.is_open()) return regioes;
+    std::string line;
+    while (std::getline(file, line)) {
+        auto pos = line.find('#');
+        if (pos != std::string::npos) line = line.substr(0, pos);
+        std::istringstream iss(line);
+        std::string medidor;
+        RegiaoInteresse roi;
+        if (!(iss >> medidor)) continue;
+        if (!(iss >> roi.x >> roi.y >> roi.largura >> roi.altura)) {
+            std::cerr << "[AVISO] Linha invalida em " << arquivo << ": " << line << "\n";
+            continue;
+        }
+        regioes[medidor] = roi;
+    }
+    std::cout << "[CONFIG] " << regioes.size() << " regiao(oes) de interesse carregada(s) de " << arquivo << "\n";
+    return regioes;
+}
+
+// Roda o pipeline de preprocessamento em cada conjunto de kernels disponível
+// e compara tempo e saída. Sem caminho, usa uma imagem sintética 1280x720.
+static void benchmarkPreprocessamento(const std::string& caminho, int repeticoes = 50) {
+    Imagem img;
+    if (caminho.empty() || !decodificarImagem(caminho, img)) {
+        if (!caminho.empty()) std::cout << "Nao foi possivel decodificar " << caminho << "; usando imagem sintetica\n";
+        img.largura = 1280; img.altura = 720; img.canais = 3;
+        img.pixels.resize(static_cast<size_t>(img.largura) * img.altura * 3);
+        uint32_t semente = 12345;
+        for (auto& px : img.pixels) { semente = semente * 1103515245u + 12345u; px = static_cast<uint8_t>(semente >> 16); }
+    }
+    ConfigLimiar cfg;
+    std::cout << "Imagem " << img.largura << "x" << img.altura << " (" << img.canais << " canal(is)), "
+              << repeticoes << " repeticoes, CPU suporta ate " << nomeModoSimd(ModoSimd::AUTO) << "\n";
+
+    auto flagsOriginais = std::cout.flags();
+    auto precisaoOriginal = std::cout.precision();
+    Imagem referencia = preprocessarImagem(img, RegiaoInteresse{}, cfg, ModoSimd::ESCALAR);
+    double msEscalar = 0.0;
+    for (ModoSimd modo : {ModoSimd::ESCALAR, ModoSimd::SSE41, ModoSimd::AVX2}) {
+        if (static_cast<int>(modo) > static_cast<int>(detectarModoSimd())) continue;
+        Imagem saida;
+        auto inicio = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeticoes; ++i) saida = preprocessarImagem(img, RegiaoInteresse{}, cfg, modo);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio).count() / repeticoes;
+        if (modo == ModoSimd::ESCALAR) msEscalar = ms;
+        std::cout << "  " << std::setw(8) << nomeModoSimd(modo) << ": " << std::fixed << std::setprecision(3) << ms
+                  << " ms/imagem (" << std::setprecision(2) << (ms > 0 ? msEscalar / ms : 0.0) << "x)"
+                  << (saida.pixels == referencia.pixels ? "" : "  [SAIDA DIVERGENTE]") << "\n";
+    }
+    std::cout.flags(flagsOriginais);
+    std::cout.precision(precisaoOriginal);
+}
+
+static const std::string CAMINHO_TEMPLATES = "./data/digitos.tpl";
+
+// Conjunto rotulado: "rotulos.txt" no diretório ("<arquivo> <valor>" por linha)
+// ou, na falta dele, o número no nome de cada imagem
+static std::vector<std::pair<std::string, std::string>> carregarConjuntoRotulado(const std::string& dir) {
+    std::vector<std::pair<std::string, std::string>> itens;
+    std::ifstream rotulos(fs::path(dir) / "rotulos.txt");
+    if (rotulos.is_open()) {
+        std::string arquivo, valor;
+        while (rotulos >> arquivo >> valor) itens.emplace_back((fs::path(dir) / arquivo).string(), valor);
+        return itens;
+    }
+    static const std::regex numRegex("(\\d+(\\.\\d+)?)");
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        if (!entry.is_regular_file() || !ehArquivoDeImagem(entry.path()) || entry.path().extension() == ".txt") continue;
+        std::string stem = entry.path().stem().string();
+        std::smatch match;
+        if (std::regex_search(stem, match, numRegex)) itens.emplace_back(entry.path().string(), match[1].str());
+    }
+    std::sort(itens.begin(), itens.end());
+    return itens;
+}
+
+static std::shared_ptr<ReconhecedorDigitos> treinarTemplates(const std::string& dir) {
+    auto modelo = std::make_shared<ReconhecedorDigitos>();
+    size_t aceitas = 0, total = 0;
+    for (const auto& [caminho, rotulo] : carregarConjuntoRotulado(dir)) {
+        Imagem img;
+        if (!decodificarImagem(caminho, img)) continue;
+        total++;
+        if (modelo->aprender(preprocessarImagem(img, RegiaoInteresse{}, ConfigLimiar{}), rotulo)) aceitas++;
+    }
+    modelo->finalizarTreino();
+    std::cout << "Treino: " << aceitas << "/" << total << " imagens aproveitadas, "
+              << modelo->numeroTemplates() << " template(s)\n";
+    return modelo;
+}
+
+// Acurácia (valor exato) e latência por imagem de cada estratégia de OCR sobre
+// um conjunto rotulado. Com rótulo vindo do nome do arquivo, a estratégia por
+// nome acerta por construção e serve só de referência de custo.
+static void avaliarEstrategiasOcr(const std::string& dirTreino, const std::string& dirAvaliacao) {
+    std::shared_ptr<ReconhecedorDigitos> modelo;
+    if (!dirTreino.empty()) {
+        modelo = treinarTemplates(dirTreino);
+        fs::create_directories(fs::path(CAMINHO_TEMPLATES).parent_path());
+        if (modelo->treinado() && modelo->salvar(CAMINHO_TEMPLATES)) std::cout << "Templates salvos em " << CAMINHO_TEMPLATES << "\n";
+    } else {
+        modelo = std::make_shared<ReconhecedorDigitos>();
+        if (!modelo->carregar(CAMINHO_TEMPLATES)) std::cout << "Sem templates em " << CAMINHO_TEMPLATES << "\n";
+    }
+
+    auto conjunto = carregarConjuntoRotulado(dirAvaliacao);
+    if (conjunto.empty()) {
+        std::cout << "Nenhuma imagem rotulada em " << dirAvaliacao << "\n";
+        return;
+    }
+
+    std::vector<std::pair<std::string, std::shared_ptr<IOcrStrategy>>> estrategias;
+    estrategias.emplace_back("nome", std::make_shared<FilenameOcrStrategy>());
+    if (modelo->treinado()) estrategias.emplace_back("templates", std::make_shared<TemplateOcrStrategy>(modelo));
+#ifdef USE_TESSERACT
+    estrategias.emplace_back("tesseract", std::make_shared<TesseractOcrStrategy>());
+#endif
+
+    auto flagsOriginais = std::cout.flags();
+    auto precisaoOriginal = std::cout.precision();
+    std::cout << conjunto.size() << " imagem(ns) rotulada(s) em " << dirAvaliacao << "\n";
+    for (auto& [nome, estrategia] : estrategias) {
+        std::vector<double> micros;
+        size_t acertos = 0;
+        for (const auto& [caminho, rotulo] : conjunto) {
+            auto inicio = std::chrono::steady_clock::now();
+            double valor = estrategia->extrairLeitura(caminho);
+            micros.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - inicio).count());
+            double esperado = 0.0;
+            extrairPrimeiroNumero(rotulo, esperado);
+            if (std::fabs(valor - esperado) < 1e-6) acertos++;
+        }
+        std::sort(micros.begin(), micros.end());
+        double media = 0.0;
+        for (double m : micros) media += m;
+        media /= micros.size();
+        std::cout << "  " << std::setw(10) << nome << ": acuracia " << std::fixed << std::setprecision(1)
+                  << 100.0 * acertos / conjunto.size() << "%  media " << media << " us  p95 "
+                  << micros[std::min(micros.size() - 1, micros.size() * 95 / 100)] << " us\n";
+    }
+    std::cout.flags(flagsOriginais);
+    std::cout.precision(precisaoOriginal);
+}
+
+// Lê as raízes de simuladores (uma por linha, '#' comenta). A ordem define o
+// prefixo: a primeira raiz gera "SHA1: ...", a segunda "SHA2: ..." e assim por diante.
+static std::vector<std::string> carregarRaizesSimuladores(const std::string& arquivo) {
+    std::vector<std::string> raizes;
+    std::ifstream file(arquivo);
+    if (!file.is_open()) {
+        std::cerr << "[AVISO] Arquivo " << arquivo << " nao encontrado. Usando ./simulators\n";
+        raizes.push_back("./simulators");
+        return raizes;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        auto pos = line.find('#');
+        if (pos != std::string::npos) line = line.substr(0, pos);
+        std::string caminho = trim(line);
+        if (!caminho.empty()) raizes.push_back(caminho);
+    }
+    std::cout << "[CONFIG] " << raizes.size() << " raiz(es) de simuladores carregada(s) de " << arquivo << "\n";
+    return raizes;
+}
+
+// Mantém o registro de simuladores da fachada em sincronia com as pastas.
+// Cada raiz só é revarrida quando o sistema de arquivos avisa que algo mudou
+// nela (inotify), e a fachada só é tocada quando o conjunto de simuladores
+// detectados muda de fato.
+class DescobertaSimuladores {
+public:
+    struct Estatisticas {
+        uint64_t varreduras = 0;
+        uint64_t conectados = 0;
+        uint64_t desconectados = 0;
+    };
+
+    DescobertaSimuladores(FachadaSMH& f, Token token, const std::vector<std::string>& caminhos)
+        : fachada(f), token(token) {
+        for (size_t i = 0; i < caminhos.size(); i++) {
+            Raiz r;
+            r.caminho = caminhos[i];
+            r.prefixo = "SHA" + std::to_string(i + 1) + ": ";
+            raizes.push_back(std::move(r));
+        }
+#ifdef __linux__
+        fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+#endif
+    }
+
+    ~DescobertaSimuladores() {
+        parar();
+#ifdef __linux__
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    void iniciar() {
+        rodando.store(true);
+        thread = std::thread(&DescobertaSimuladores::loop, this);
+    }
+
+    void parar() {
+        rodando.store(false);
+        if (thread.joinable()) thread.join();
+    }
+
+    Estatisticas estatisticas() const {
+        return {varreduras.load(), conectados.load(), desconectados.load()};
+    }
+
+private:
+    struct Raiz {
+        std::string caminho;
+        std::string prefixo;
+        std::string pastaMedicao;
+        std::map<std::string, std::string> simuladores; // idSHA -> pasta
+        bool suja = true;
+        int wdRaiz = -1;
+        int wdMedicao = -1;
+    };
+
+    struct Varredura {
+        std::string pastaMedicao;
+        std::map<std::string, std::string> simuladores;
+    };
+
+    // Sem notificações (ou raiz ainda inexistente), revarre com esta frequência
+    static constexpr auto INTERVALO_REVARREDURA = std::chrono::seconds(60);
+
+    FachadaSMH& fachada;
+    Token token; // admin: desconectarSimulador exige
+    std::vector<Raiz> raizes;
+    std::thread thread;
+    std::atomic<bool> rodando{false};
+    std::atomic<uint64_t> varreduras{0};
+    std::atomic<uint64_t> conectados{0};
+    std::atomic<uint64_t> desconectados{0};
+    int fd = -1;
+
+    // Só lê o sistema de arquivos; não toca na fachada
+    static Varredura varrer(const Raiz& raiz) {
+        Varredura v;
+        if (!fs::exists(raiz.caminho)) return v;
+
+        // 1. Pasta medicoes_* mais recente
+        fs::path pastaFinal;
+        fs::file_time_type dataFinal{};
+        for (const auto& entry : fs::directory_iterator(raiz.caminho)) {
+            if (!entry.is_directory()) continue;
+            std::string nomeLower = entry.path().filename().string();
+            std::transform(nomeLower.begin(), nomeLower.end(), nomeLower.begin(), ::tolower);
+            if (nomeLower.find("medicoes_") != 0) continue;
+            auto data = entry.last_write_time();
+            if (pastaFinal.empty() || data > dataFinal) {
+                pastaFinal = entry.path();
+                dataFinal = data;
+            }
+        }
+        if (pastaFinal.empty()) return v;
+        v.pastaMedicao = pastaFinal.string();
+
+        // 2. Subpastas viram "SHAx: <nome>"; 3. sem subpastas, imagens soltas viram "SHAx: hidrometro"
+        bool temImagens = false;
+        for (const auto& entry : fs::directory_iterator(pastaFinal)) {
+            if (entry.is_directory()) {
+                v.simuladores[raiz.prefixo + entry.path().filename().string()] = entry.path().string();
+            } else if (!temImagens && entry.is_regular_file() && ehArquivoDeImagem(entry.path())) {
+                temImagens = true;
+            }
+        }
+        if (v.simuladores.empty() && temImagens) {
+            v.simuladores[raiz.prefixo + "hidrometro"] = v.pastaMedicao;
+        }
+        return v;
+    }
+
+    void aplicar(Raiz& raiz, Varredura&& v) {
+        for (const auto& [id, pasta] : raiz.simuladores) {
+            auto it = v.simuladores.find(id);
+            if (it == v.simuladores.end()) {
+                fachada.desconectarSimulador(id, token);
+                desconectados++;
+            }
+        }
+        for (const auto& [id, pasta] : v.simuladores) {
+            auto it = raiz.simuladores.find(id);
+            if (it != raiz.simuladores.end() && it->second == pasta) continue;
+            std::map<std::string, std::string> params;
+            params["tipo"] = "arquivo";
+            params["caminho"] = pasta;
+            params["idSHA"] = id;
+            params["modo"] = "eventos";
+            fachada.conectarSimulador(params, token);
+            conectados++;
+        }
+        raiz.simuladores = std::move(v.simuladores);
+        if (raiz.pastaMedicao != v.pastaMedicao) {
+            raiz.pastaMedicao = v.pastaMedicao;
+            atualizarWatchMedicao(raiz);
+        }
+    }
+
+    void atualizarWatchRaiz(Raiz& raiz) {
+#ifdef __linux__
+        if (fd < 0 || raiz.wdRaiz >= 0 || !fs::exists(raiz.caminho)) return;
+        raiz.wdRaiz = inotify_add_watch(fd, raiz.caminho.c_str(),
+                                        IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE_SELF | IN_MOVE_SELF);
+#endif
+    }
+
+    void atualizarWatchMedicao(Raiz& raiz) {
+#ifdef __linux__
+        if (fd < 0) return;
+        if (raiz.wdMedicao >= 0) inotify_rm_watch(fd, raiz.wdMedicao);
+        raiz.wdMedicao = -1;
+        if (raiz.pastaMedicao.empty()) return;
+        raiz.wdMedicao = inotify_add_watch(fd, raiz.pastaMedicao.c_str(),
+                                           IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM | IN_CLOSE_WRITE | IN_DELETE_SELF);
+#endif
+    }
+
+#ifdef __linux__
+    // Marca como sujas as raízes afetadas pelos eventos pendentes
+    void lerEventos(int timeoutMs) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, timeoutMs) <= 0) return;
+        alignas(inotify_event) char buf[16 * 1024];
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + n;) {
+                auto* ev = reinterpret_cast<inotify_event*>(p);
+                p += sizeof(inotify_event) + ev->len;
+                if (ev->mask & IN_Q_OVERFLOW) {
+                    for (auto& r : raizes) r.suja = true;
+                    continue;
+                }
+                for (auto& r : raizes) {
+                    if (ev->wd == r.wdRaiz) {
+                        if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) r.wdRaiz = -1;
+                        // Na raiz só interessam pastas (medicoes_*)
+                        if ((ev->mask & IN_ISDIR) || r.wdRaiz < 0) r.suja = true;
+                    } else if (ev->wd == r.wdMedicao) {
+                        if (ev->mask & (IN_DELETE_SELF | IN_IGNORED)) {
+                            r.wdMedicao = -1;
+                            r.suja = true;
+                        } else if (ev->mask & IN_ISDIR) {
+                            r.suja = true;
+                        } else if (r.simuladores.empty()) {
+                            // Aguardando a primeira imagem solta; depois disso arquivos novos não mudam o conjunto
+                            r.suja = true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+#endif
+
+    void loop() {
+        auto ultimaRevarredura = std::chrono::steady_clock::now();
+        while (rodando.load()) {
+            std::vector<Raiz*> sujas;
+            for (auto& r : raizes) {
+                if (r.suja) sujas.push_back(&r);
+            }
+
+            if (!sujas.empty()) {
+                // Varreduras em paralelo (só I/O de leitura); aplicação sequencial
+                std::vector<std::future<Varredura>> futuros;
+                for (Raiz* r : sujas) {
+                    r->suja = false;
+                    futuros.push_back(std::async(std::launch::async, [r] { return varrer(*r); }));
+                }
+                for (size_t i = 0; i < sujas.size(); i++) {
+                    try {
+                        Varredura v = futuros[i].get();
+                        varreduras++;
+                        atualizarWatchRaiz(*sujas[i]);
+                        aplicar(*sujas[i], std::move(v));
+                    } catch (const std::exception& e) {
+                        LogManager::getInstance().log(std::string("[Descoberta] Erro ao varrer ") + sujas[i]->caminho + ": " + e.what());
+                    }
+                }
+            }
+
+#ifdef __linux__
+            if (fd >= 0) {
+                lerEventos(1000);
+            } else {
+                std::this_thread::sleep_for(std::chrono::seconds(5));
+                for (auto& r : raizes) r.suja = true;
+            }
+#else
+            std::this_thread::sleep_for(std::chrono::seconds(5));
+            for (auto& r : raizes) r.suja = true;
+#endif
+            // Rede de segurança: raízes sem watch (ainda inexistentes) e eventos perdidos
+            auto agora = std::chrono::steady_clock::now();
+            if (agora - ultimaRevarredura >= INTERVALO_REVARREDURA) {
+                ultimaRevarredura = agora;
+                for (auto& r : raizes) r.suja = true;
+            }
+        }
+    }
+};
+
+// intervalos.conf: "<idSHA> <segundos>" por linha ('#' comenta). O id pode ter
+// espaços ("SHA1: hidrometro1"), então o número é sempre o último campo.
+static std::map<std::string, std::chrono::milliseconds> carregarIntervalosHidrometros(const std::string& arquivo) {
+    std::map<std::string, std::chrono::milliseconds> intervalos;
+    std::ifstream file(arquivo);
+    if (!file.is_open()) return intervalos;
+    std::string line;
+    while (std::getline(file, line)) {
+        auto pos = line.find('#');
+        if (pos != std::string::npos) line = line.substr(0, pos);
+        line = trim(line);
+        auto sep = line.find_last_of(" \t");
+        if (sep == std::string::npos) continue;
+        try {
+            double segundos = std::stod(line.substr(sep + 1));
+            if (segundos > 0) intervalos[trim(line.substr(0, sep))] = std::chrono::milliseconds(static_cast<int64_t>(segundos * 1000));
+        } catch (...) {
+            std::cerr << "[AVISO] Linha invalida em " << arquivo << ": " << line << "\n";
+        }
+    }
+    std::cout << "[CONFIG] " << intervalos.size() << " intervalo(s) de leitura carregado(s) de " << arquivo << "\n";
+    return intervalos;
+}
+
+// alertas.conf: "<chave> <valor>" por linha ('#' comenta). Chaves: cooldown e
+// dedup em segundos, tolerancia (fração do consumo), escalar (supressões seguidas).
+static PoliticaAlerta carregarPoliticaAlerta(const std::string& arquivo) {
+    PoliticaAlerta politica;
+    std::ifstream file(arquivo);
+    if (!file.is_open()) return politica;
+    std::string line;
+    while (std::getline(file, line)) {
+        auto pos = line.find('#');
+        if (pos != std::string::npos) line = line.substr(0, pos);
+        std::istringstream iss(line);
+        std::string chave;
+        double valor;
+        if (!(iss >> chave >> valor)) continue;
+        if (chave == "cooldown") politica.cooldown = std::chrono::seconds(static_cast<int64_t>(valor));
+        else if (chave == "dedup") politica.janelaDedup = std::chrono::seconds(static_cast<int64_t>(valor));
+        else if (chave == "tolerancia") politica.toleranciaDedup = valor;
+        else if (chave == "escalar") politica.suprimidosParaEscalar = static_cast<int>(valor);
+        else std::cerr << "[AVISO] Chave desconhecida em " << arquivo << ": " << chave << "\n";
+    }
+    std::cout << "[CONFIG] Politica de alerta: cooldown " << politica.cooldown.count() << " s, dedup "
+              << politica.janelaDedup.count() << " s, escalar apos " << politica.suprimidosParaEscalar << " supressao(oes)\n";
+    return politica;
+}
+
+// Várias threads martelando a mesma TabelaCooldown (isolada da do serviço).
+// Com o relógio parado cada chave é avaliada em sequência sob a trava do seu
+// shard, então os totais são exatos: 1 envio por chave e, com escalonamento a
+// cada N, (chamadas - 1) / N escalados.
+static void estresseCooldown(int numThreads = 8, int usuarios = 1000, int regrasPorUsuario = 4, int voltas = 50) {
+    const int escalarApos = 5;
+    PoliticaAlerta politica;
+    politica.cooldown = std::chrono::seconds(3600);
+    politica.suprimidosParaEscalar = escalarApos;
+    TabelaCooldown tabela(politica);
+    const auto agora = TabelaCooldown::Relogio::now();
+    const int chaves = usuarios * regrasPorUsuario;
+
+    auto inicio = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int v = 0; v < voltas; ++v) {
+                for (int k = 0; k < chaves; ++k) {
+                    int c = (k * 7919 + t * 104729) % chaves; // ordem diferente por thread
+                    tabela.avaliar(c / regrasPorUsuario, c % regrasPorUsuario + 1, 1.0, agora);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    double seg = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+
+    const uint64_t chamadasPorChave = static_cast<uint64_t>(numThreads) * voltas;
+    const uint64_t total = chamadasPorChave * chaves;
+    auto est = tabela.estatisticas();
+    uint64_t esperadosEscalados = (chamadasPorChave - 1) / escalarApos * chaves;
+    bool ok = est.enviados == static_cast<uint64_t>(chaves) && est.escalados == esperadosEscalados &&
+              est.enviados + est.escalados + est.suprimidosCooldown + est.suprimidosDuplicados == total &&
+              tabela.tamanho() == static_cast<size_t>(chaves);
+
+    std::cout << numThreads << " threads, " << chaves << " chaves (usuario, regra), " << total << " avaliacoes em "
+              << seg * 1000.0 << " ms (" << (seg > 0 ? total / seg / 1e6 : 0.0) << " M/s)\n";
+    std::cout << "  enviados " << est.enviados << " (esperado " << chaves << "), escalados " << est.escalados
+              << " (esperado " << esperadosEscalados << "), suprimidos " << est.suprimidosCooldown << "\n";
+    std::cout << (ok ? ">> OK: contagens consistentes\n" : ">> FALHA: contagens divergentes\n");
+}
+
+// Agenda cada hidrômetro vinculado pelo seu próprio prazo numa RodaTemporizacao,
+// em vez de varrer todos os usuários a cada 5 s. Medidor vencido é verificado
+// no PoolTarefas: se a imagem mais recente mudou (caminho ou mtime), os donos
+// são reavaliados e o intervalo volta ao base; se não mudou, o intervalo cresce
+// (backoff) até o teto. Atraso = início da verificação - prazo agendado.
+class AgendadorHidrometros {
+public:
+    struct Config {
+        std::chrono::milliseconds intervaloPadrao{5000};
+        std::chrono::milliseconds intervaloMaximo{60000};       // teto do backoff de medidor ocioso
+        double fatorBackoff = 2.0;
+        std::chrono::milliseconds intervaloSincronizacao{5000}; // releitura de usuários e vínculos
+        std::chrono::milliseconds prazoAvaliacao{60000};        // espera máxima por um ciclo
+        std::map<std::string, std::chrono::milliseconds> intervalos; // por idSHA
+    };
+
+    struct Estatisticas {
+        size_t agendados = 0;
+        uint64_t verificacoes = 0;
+        uint64_t mudancas = 0;
+        uint64_t avaliacoes = 0;
+        double atrasoMedioMs = 0.0;
+        int64_t atrasoMaximoMs = 0;
+        int64_t atrasoUltimoMs = 0;
+    };
+
+    AgendadorHidrometros(FachadaSMH& f, Token token, Config cfg)
+        : fachada(f), token(token), cfg(std::move(cfg)) {}
+
+    ~AgendadorHidrometros() { parar(); }
+
+    void iniciar() {
+        rodando.store(true);
+        thread = std::thread(&AgendadorHidrometros::loop, this);
+    }
+
+    void parar() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            rodando.store(false);
+        }
+        cv.notify_all();
+        if (thread.joinable()) thread.join();
+        // Ciclos em andamento no pool terminam antes de o agendador sumir
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [&] { return ciclosEmAndamento == 0; });
+    }
+
+    Estatisticas estatisticas() const {
+        Estatisticas e;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            e.agendados = medidores.size();
+        }
+        e.verificacoes = verificacoes.load();
+        e.mudancas = mudancas.load();
+        e.avaliacoes = avaliacoes.load();
+        e.atrasoMedioMs = e.verificacoes ? static_cast<double>(somaAtrasoMs.load()) / e.verificacoes : 0.0;
+        e.atrasoMaximoMs = atrasoMaximoMs.load();
+        e.atrasoUltimoMs = atrasoUltimoMs.load();
+        return e;
+    }
+
+private:
+    using Relogio = std::chrono::steady_clock;
+
+    struct Medidor {
+        std::chrono::milliseconds intervaloBase;
+        std::chrono::milliseconds intervaloAtual;
+        std::string assinatura; // caminho + mtime da última imagem vista
+    };
+
+    FachadaSMH& fachada;
+    Token token;
+    Config cfg;
+
+    mutable std::mutex m;
+    std::condition_variable cv;
+    RodaTemporizacao roda;
+    std::map<std::string, Medidor> medidores; // só os vinculados e detectados
+    std::shared_ptr<const std::map<std::string, std::vector<Usuario>>> donos =
+        std::make_shared<const std::map<std::string, std::vector<Usuario>>>();
+    int ciclosEmAndamento = 0;
+    std::set<int> emAvaliacao; // usuários com avaliação em andamento em algum ciclo
+
+    std::thread thread;
+    std::atomic<bool> rodando{false};
+    std::atomic<uint64_t> verificacoes{0};
+    std::atomic<uint64_t> mudancas{0};
+    std::atomic<uint64_t> avaliacoes{0};
+    std::atomic<int64_t> somaAtrasoMs{0};
+    std::atomic<int64_t> atrasoMaximoMs{0};
+    std::atomic<int64_t> atrasoUltimoMs{0};
+
+    std::chrono::milliseconds intervaloBaseDe(const std::string& sha) const {
+        auto it = cfg.intervalos.find(sha);
+        return it != cfg.intervalos.end() ? it->second : cfg.intervaloPadrao;
+    }
+
+    // Medidores passam a ser agendados quando ganham dono e estão online; saem
+    // da roda quando perdem o vínculo ou desaparecem
+    void sincronizar() {
+        auto usuarios = fachada.listarTodosUsuarios(token);
+        auto detectadosLista = fachada.listarSimuladoresDetectados();
+        std::set<std::string> detectados(detectadosLista.begin(), detectadosLista.end());
+
+        auto novoDonos = std::make_shared<std::map<std::string, std::vector<Usuario>>>();
+        for (const auto& u : usuarios) {
+            for (const auto& sha : u.hidrometros) {
+                if (detectados.count(sha)) (*novoDonos)[sha].push_back(u);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m);
+        auto agora = Relogio::now();
+        for (auto it = medidores.begin(); it != medidores.end();) {
+            if (novoDonos->count(it->first)) { ++it; continue; }
+            roda.cancelar(it->first);
+            it = medidores.erase(it);
+        }
+        for (const auto& [sha, lista] : *novoDonos) {
+            if (medidores.count(sha)) continue;
+            auto base = intervaloBaseDe(sha);
+            medidores[sha] = Medidor{base, base, ""};
+            roda.agendar(sha, agora);
+        }
+        donos = std::move(novoDonos);
+    }
+
+    void loop() {
+        auto proximaSincronizacao = Relogio::now();
+        while (rodando.load()) {
+            auto agora = Relogio::now();
+            if (agora >= proximaSincronizacao) {
+                try { sincronizar(); } catch (const std::exception& e) {
+                    LogManager::getInstance().log(std::string("Agendador: falha ao sincronizar: ") + e.what());
+                }
+                proximaSincronizacao = agora + cfg.intervaloSincronizacao;
+            }
+
+            std::vector<RodaTemporizacao::Vencimento> vencidos;
+            {
+                std::unique_lock<std::mutex> lock(m);
+                vencidos = roda.avancar(Relogio::now());
+                if (!vencidos.empty()) ciclosEmAndamento++;
+            }
+            if (!vencidos.empty()) {
+                PoolTarefas::getInstance().submeter([this, v = std::move(vencidos)]() mutable { executarCiclo(std::move(v)); });
+            }
+
+            std::unique_lock<std::mutex> lock(m);
+            cv.wait_for(lock, roda.resolucao(), [&] { return !rodando.load(); });
+        }
+    }
+
+    void registrarAtraso(Relogio::time_point prazo) {
+        int64_t atraso = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(Relogio::now() - prazo).count());
+        verificacoes++;
+        somaAtrasoMs += atraso;
+        atrasoUltimoMs = atraso;
+        int64_t maximo = atrasoMaximoMs.load();
+        while (atraso > maximo && !atrasoMaximoMs.compare_exchange_weak(maximo, atraso)) {}
+    }
+
+    // Assinatura da imagem atual ("" se offline/sem imagem)
+    std::string assinaturaAtual(const std::string& sha) {
+        try {
+            std::string caminho = fachada.obterCaminhoImagemAtual(sha);
+            std::error_code ec;
+            auto mtime = fs::last_write_time(caminho, ec);
+            return caminho + "|" + std::to_string(mtime.time_since_epoch().count());
+        } catch (const std::exception&) {
+            return "";
+        }
+    }
+
+    // Encerra o ciclo mesmo se a avaliação lançar: libera os usuários reservados
+    // e desconta ciclosEmAndamento, senão parar() esperaria para sempre
+    struct FimDeCiclo {
+        AgendadorHidrometros& dono;
+        std::vector<int> reservados;
+        explicit FimDeCiclo(AgendadorHidrometros& d) : dono(d) {}
+        ~FimDeCiclo() {
+            std::lock_guard<std::mutex> lock(dono.m);
+            for (int id : reservados) dono.emAvaliacao.erase(id);
+            dono.ciclosEmAndamento--;
+            dono.cv.notify_all();
+        }
+        FimDeCiclo(const FimDeCiclo&) = delete;
+        FimDeCiclo& operator=(const FimDeCiclo&) = delete;
+    };
+
+    void executarCiclo(std::vector<RodaTemporizacao::Vencimento> vencidos) {
+        FimDeCiclo fim(*this);
+        GrupoTarefas grupo(PoolTarefas::getInstance());
+        auto prazo = Relogio::now() + cfg.prazoAvaliacao;
+
+        // 1. Verifica os medidores vencidos em paralelo (só caminho + mtime, sem OCR)
+        std::vector<std::future<std::string>> assinaturas;
+        for (const auto& v : vencidos) {
+            assinaturas.push_back(grupo.submeter([this, v]() {
+                registrarAtraso(v.prazo);
+                return assinaturaAtual(v.chave);
+            }));
+        }
+
+        // Medidor que mudou reserva seus donos em emAvaliacao. Se algum dono já
+        // está sendo avaliado por outro ciclo, a mudança não é consumida: o
+        // medidor volta no intervalo base e é reavaliado quando o dono liberar.
+        std::map<int, Usuario> afetados;
+        for (size_t i = 0; i < vencidos.size(); ++i) {
+            std::string assinatura = grupo.aguardar(assinaturas[i], prazo) ? assinaturas[i].get() : "";
+            std::lock_guard<std::mutex> lock(m);
+            auto it = medidores.find(vencidos[i].chave);
+            if (it == medidores.end()) continue; // desvinculado durante o ciclo
+            Medidor& med = it->second;
+            if (!assinatura.empty() && assinatura != med.assinatura) {
+                auto d = donos->find(vencidos[i].chave);
+                const std::vector<Usuario> semDonos;
+                const auto& lista = d != donos->end() ? d->second : semDonos;
+                bool ocupado = std::any_of(lista.begin(), lista.end(), [&](const Usuario& u) {
+                    return emAvaliacao.count(u.id) && !afetados.count(u.id);
+                });
+                med.intervaloAtual = med.intervaloBase;
+                if (!ocupado) {
+                    med.assinatura = assinatura;
+                    mudancas++;
+                    for (const auto& u : lista) {
+                        if (afetados.emplace(u.id, u).second) {
+                            emAvaliacao.insert(u.id);
+                            fim.reservados.push_back(u.id);
+                        }
+                    }
+                }
+            } else {
+                auto proximo = std::chrono::milliseconds(static_cast<int64_t>(med.intervaloAtual.count() * cfg.fatorBackoff));
+                med.intervaloAtual = std::min(std::max(proximo, med.intervaloBase), std::max(cfg.intervaloMaximo, med.intervaloBase));
+            }
+            roda.agendar(vencidos[i].chave, Relogio::now() + med.intervaloAtual);
+        }
+
+        // 2. Reavalia uma vez cada dono de medidor que mudou
+        std::vector<Usuario> usuarios;
+        for (auto& [id, u] : afetados) usuarios.push_back(std::move(u));
+        try {
+            fachada.monitorarUsuarios(usuarios);
+            avaliacoes += usuarios.size();
+        } catch (const std::exception& e) {
+            LogManager::getInstance().log(std::string("Agendador: falha ao avaliar: ") + e.what());
+        }
+    }
+};
+
 static SmtpConfig carregarSmtpConfig() {
     SmtpConfig cfg;
     
@@ -571,6 +2263,16 @@ static SmtpConfig carregarSmtpConfig() {
                     cfg.from = value;
                 } else if (key == "SMTP_PASSWORD") {
                     cfg.pass = value;
+                } else if (key == "SMTP_SERVER") {
+                    cfg.server = value;
+                } else if (key == "SMTP_PORT") {
+                    try { cfg.port = std::stoi(value); } catch (...) {}
+                } else if (key == "SMTP_SECURE") {
+                    if (value == "none") cfg.secure = SmtpEmailService::SecureMode::NONE;
+                    else if (value == "smtps") cfg.secure = SmtpEmailService::SecureMode::SMTPS;
+                    else cfg.secure = SmtpEmailService::SecureMode::STARTTLS;
+                } else if (key == "SMTP_RESUMO_SEGUNDOS") {
+                    try { cfg.janelaResumo = std::chrono::seconds(std::stoi(value)); } catch (...) {}
                 }
             }
         }
@@ -595,8 +2297,12 @@ int main() {
     std::shared_ptr<IHistoricoRepository> historicoRepo;
 
     #ifdef USE_SQLITE3
-    usuarioRepo = std::make_shared<UsuarioRepositorySQLite>("./data/smh.db");
-    historicoRepo = std::make_shared<HistoricoRepositorySQLite>("./data/smh.db");
+    // Usuários e vínculos mudam pouco e são lidos a cada ciclo: cache na frente do banco
+    usuarioRepo = std::make_shared<UsuarioRepositoryCache>(std::make_shared<UsuarioRepositorySQLite>("./data/smh.db"));
+    auto historicoSQLite = std::make_shared<HistoricoRepositorySQLite>("./data/smh.db");
+    // Leituras vão para uma fila e são gravadas em lote por uma thread dedicada
+    historicoSQLite->ativarEscritaAssincrona();
+    historicoRepo = historicoSQLite;
     #else
     usuarioRepo = std::make_shared<UsuarioRepositoryMemory>();
     historicoRepo = std::make_shared<HistoricoRepositoryMemory>();
@@ -605,7 +2311,24 @@ int main() {
     auto& fachada = FachadaSMH::getInstance();
     fachada.setRepository(usuarioRepo);
     fachada.setHistoricoRepository(historicoRepo);
-    fachada.setOcrStrategy(std::make_shared<FilenameOcrStrategy>());
+    // Imagem inalterada não passa pelo OCR de novo (monitor + tela de status)
+#ifdef USE_TESSERACT
+    std::shared_ptr<IOcrStrategy> ocrBase = std::make_shared<TesseractOcrStrategy>();
+#else
+    std::shared_ptr<IOcrStrategy> ocrBase = std::make_shared<FilenameOcrStrategy>();
+#endif
+    auto templatesDigitos = std::make_shared<ReconhecedorDigitos>();
+    if (templatesDigitos->carregar(CAMINHO_TEMPLATES)) {
+        std::cout << "[CONFIG] " << templatesDigitos->numeroTemplates() << " template(s) de digitos carregado(s)\n";
+        ocrBase = std::make_shared<TemplateOcrStrategy>(templatesDigitos, ocrBase);
+    }
+    // Recorte + limiar só quando há ROIs configuradas
+    auto regioes = carregarRegioesInteresse("roi.conf");
+    if (!regioes.empty()) {
+        std::cout << "[CONFIG] " << regioes.size() << " regiao(oes) de interesse para OCR\n";
+        ocrBase = std::make_shared<PreprocessamentoOcrStrategy>(ocrBase, std::move(regioes));
+    }
+    fachada.setOcrStrategy(std::make_shared<CachedOcrStrategy>(ocrBase));
     fachada.registrarObservador(std::make_shared<PainelObserver>());
 
     const auto smtpCfg = carregarSmtpConfig();
@@ -618,6 +2341,7 @@ int main() {
                 if (u.email.empty()) continue;
                 auto svc = std::make_shared<SmtpEmailService>(smtpCfg.server, smtpCfg.port, smtpCfg.from,
                                                              u.email, smtpCfg.user, smtpCfg.pass, smtpCfg.secure, u.id);
+                svc->definirJanelaResumo(smtpCfg.janelaResumo);
                 fachada.registrarObservador(svc);
             }
         } catch(...) {}
@@ -631,20 +2355,21 @@ int main() {
             for (const auto& u : users) {
                 auto regrasBD = historicoRepo->listarRegrasPorUsuario(u.id);
 
-                // Se o usuário não tiver regra persistida, cria uma padrão (limite 3.0)
-                // if (regrasBD.empty()) {
-                //     fachada.configurarRegraAlerta(u.id, "limite", 3.0);
-                //     continue;
-                // }
-
-                fachada.configurarRegraAlerta(u.id, "limite", 4.0);
+                // Se o usuário não tiver regra persistida, cria uma padrão (limite 4.0)
+                if (regrasBD.empty()) {
+                    fachada.configurarRegraAlerta(u.id, "limite", 4.0);
+                    continue;
+                }
 
-                // Restaura regras existentes
-                // for (const auto& r : regrasBD) {
-                //     std::string tipo = std::get<2>(r);
-                //     double valor = std::get<3>(r);
-                //     fachada.configurarRegraAlerta(u.id, tipo, valor);
-                // }
+                // Restaura regras existentes com o id do banco (chave estável do cooldown).
+                // Versões antigas gravavam a regra padrão a cada início: repetidas
+                // (mesmo tipo e valor) voltam uma vez só, com o id mais antigo.
+                std::sort(regrasBD.begin(), regrasBD.end());
+                std::set<std::pair<std::string, double>> restauradas;
+                for (const auto& r : regrasBD) {
+                    if (!restauradas.emplace(std::get<2>(r), std::get<3>(r)).second) continue;
+                    fachada.restaurarRegraAlerta(u.id, std::get<0>(r), std::get<2>(r), std::get<3>(r));
+                }
             }
             std::cout << "[SISTEMA] Regras de alerta restauradas do banco de dados.\n";
         } catch(...) {}
@@ -662,103 +2387,18 @@ int main() {
         tokenAdmin = Token{adminUser->id, Perfil::ADMIN};
     }
 
-    // 3. Thread de Monitoramento (ID com "SHA X: ...")
-    std::atomic<bool> running(true);
-    std::thread monitorThread([&]() {
-        std::vector<std::string> locaisDosSHAs;
-        
-        // Adicione seus caminhos aqui
-        locaisDosSHAs.push_back("C:/Users/Jefferson/Projetos/padroes_projetos/simulador-hidrometro-analogico-v2");
-        locaisDosSHAs.push_back("C:/Users/Jefferson/Projetos/padroes_projetos/simulador-hidrometro/images"); 
-
-        while(running.load()) {
-            try {
-                // 1. Monitoramento de Consumo (Alertas em Background)
-                auto users = usuarioRepo->listarTodosUsuarios();
-                // std::cout << "[DEBUG-THREAD] Monitorando " << users.size() << " usuarios..." << std::endl;
-                for (const auto& u : users) {
-                    FachadaSMH::getInstance().monitorarConsumo(u.id);
-                }
-
-                // 2. Detecção de Novos Simuladores
-                int indexSHA = 0;
-                for (const auto& raizSHA : locaisDosSHAs) {
-                    indexSHA++;
-                    
-                    // --- MUDANÇA AQUI: Separador é ": " ---
-                    std::string prefixoSHA = "SHA" + std::to_string(indexSHA) + ": "; 
-
-                    if (!fs::exists(raizSHA)) continue;
-
-                    // 1. Busca pasta medicoes
-                    std::vector<fs::path> pastasMedicao;
-                    for (const auto& entry : fs::directory_iterator(raizSHA)) {
-                        if (entry.is_directory()) {
-                            std::string nomeLower = entry.path().filename().string();
-                            std::transform(nomeLower.begin(), nomeLower.end(), nomeLower.begin(), ::tolower);
-                            if (nomeLower.find("medicoes_") == 0) {
-                                pastasMedicao.push_back(entry.path());
-                            }
-                        }
-                    }
-
-                    if (pastasMedicao.empty()) continue;
-
-                    std::sort(pastasMedicao.begin(), pastasMedicao.end(), [](const fs::path& a, const fs::path& b) {
-                        return fs::last_write_time(a) > fs::last_write_time(b);
-                    });
-                    std::string pathFinal = pastasMedicao[0].string();
-
-                    // 2. DETECTA SUBPASTAS (O <numero> vem do nome da pasta)
-                    bool achouSubpastas = false;
-                    for (const auto& entry : fs::directory_iterator(pathFinal)) {
-                        if (entry.is_directory()) {
-                            achouSubpastas = true;
-                            std::string nomeOriginal = entry.path().filename().string(); // Ex: "hidrometro1"
-                            
-                            // Gera: "SHA1: hidrometro1"
-                            std::string idComposto = prefixoSHA + nomeOriginal;
-                            
-                            std::map<std::string, std::string> params;
-                            params["tipo"] = "arquivo";
-                            params["caminho"] = entry.path().string();
-                            params["idSHA"] = idComposto;
-                            
-                            FachadaSMH::getInstance().conectarSimulador(params, Token{0, Perfil::ADMIN});
-                        }
-                    }
+    // 3. Descoberta de simuladores (raízes em simuladores.conf, IDs "SHA X: ...")
+    DescobertaSimuladores descoberta(fachada, tokenAdmin, carregarRaizesSimuladores("simuladores.conf"));
+    descoberta.iniciar();
 
-                    // 3. DETECTA IMAGENS SOLTAS (Sem numero, apenas "hidrometro")
-                    if (!achouSubpastas) {
-                        bool temImagens = false;
-                        for (const auto& entry : fs::directory_iterator(pathFinal)) {
-                            if (entry.is_regular_file()) {
-                                std::string ext = entry.path().extension().string();
-                                std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-                                if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".txt") {
-                                    temImagens = true;
-                                    break;
-                                }
-                            }
-                        }
+    // 4. Repetição de alertas (cooldown/dedup/escalonamento por usuário e regra)
+    fachada.configurarPoliticaAlerta(carregarPoliticaAlerta("alertas.conf"));
 
-                        if (temImagens) {
-                            // Gera: "SHA2: hidrometro"
-                            std::string idFixo = prefixoSHA + "hidrometro"; 
-                            
-                            std::map<std::string, std::string> params;
-                            params["tipo"] = "arquivo";
-                            params["caminho"] = pathFinal; 
-                            params["idSHA"] = idFixo;
-
-                            FachadaSMH::getInstance().conectarSimulador(params, Token{0, Perfil::ADMIN});
-                        }
-                    }
-                }
-            } catch (...) {}
-            std::this_thread::sleep_for(std::chrono::seconds(5));
-        }
-    });
+    // 5. Monitoramento em background: cada hidrômetro vinculado tem seu próprio prazo
+    AgendadorHidrometros::Config cfgAgendador;
+    cfgAgendador.intervalos = carregarIntervalosHidrometros("intervalos.conf");
+    AgendadorHidrometros agendador(fachada, tokenAdmin, cfgAgendador);
+    agendador.iniciar();
 
     int opcao = -1;
     while (opcao != 0) {
@@ -781,6 +2421,7 @@ int main() {
                         if (!u.email.empty()) {
                             auto svc = std::make_shared<SmtpEmailService>(smtpCfg.server, smtpCfg.port, smtpCfg.from,
                                                                          u.email, smtpCfg.user, smtpCfg.pass, smtpCfg.secure, u.id);
+                            svc->definirJanelaResumo(smtpCfg.janelaResumo);
                             fachada.registrarObservador(svc);
                         }
                     } catch(...) {}
@@ -814,8 +2455,8 @@ int main() {
                     
                     // 1. MOSTRA OS VINCULADOS
                     bool temVinculo = false;
+                    fachada.monitorarUsuarios(users);
                     for (const auto& u : users) {
-                        fachada.monitorarConsumo(u.id); 
                         for (const auto& sha : u.hidrometros) {
                             temVinculo = true;
                             shasVinculados.push_back(sha); // Marca como usado
@@ -858,6 +2499,28 @@ int main() {
                     }
                     if (!temDisponivel) std::cout << "   (Nenhum hidrometro extra encontrado na pasta)\n";
 
+                    auto est = agendador.estatisticas();
+                    std::cout << "--------------------------------------------------------------\n";
+                    std::cout << "   AGENDADOR: " << est.agendados << " medidor(es), " << est.verificacoes << " verificacoes, "
+                              << est.mudancas << " mudancas, atraso medio " << est.atrasoMedioMs << " ms (max "
+                              << est.atrasoMaximoMs << " ms, ultimo " << est.atrasoUltimoMs << " ms)\n";
+                    auto estLeituras = fachada.estatisticasLeituras();
+                    std::cout << "   LEITURAS: " << estLeituras.leituras << " fisicas, " << estLeituras.evitadas
+                              << " evitadas por hidrometro compartilhado\n";
+                    #ifdef USE_SQLITE3
+                    auto estEscrita = historicoSQLite->estatisticasEscrita();
+                    std::cout << "   ESCRITA: " << estEscrita.gravadas << " leituras gravadas em " << estEscrita.lotes << " lotes, "
+                              << estEscrita.falhas << " perdidas, " << estEscrita.pendentes << " na fila\n";
+                    #endif
+                    auto estNotif = fachada.estatisticasNotificacoes();
+                    std::cout << "   NOTIFICACOES: " << estNotif.entregues << " entregues, " << estNotif.pendentes << " na fila ("
+                              << estNotif.canais << " canais), " << estNotif.retentativas << " retentativas, "
+                              << estNotif.desistencias << " desistencias, " << estNotif.coalescidos << " coalescidas, "
+                              << estNotif.descartados << " descartadas, " << estNotif.resumos << " resumos\n";
+                    auto estSmtp = SmtpEmailService::estatisticas();
+                    std::cout << "   SMTP: " << estSmtp.emails << " e-mails (" << estSmtp.alertas << " alertas) em "
+                              << estSmtp.conexoesNovas << " conexao(oes), " << estSmtp.falhas << " falhas\n";
+
                     std::cout << "==============================================================\n";
                     break;
                 }
@@ -885,13 +2548,46 @@ int main() {
                     std::cout << ">> Hidrometro desvinculado com sucesso (se existia)!\n";
                     break;
                 }
+
+                case 7: {
+                    std::string caminho;
+                    std::cin.ignore(10000, '\n');
+                    std::cout << "Caminho da imagem (ENTER = sintetica): ";
+                    std::getline(std::cin, caminho);
+                    benchmarkPreprocessamento(trim(caminho));
+                    break;
+                }
+
+                case 8: {
+                    std::string dirTreino, dirAvaliacao;
+                    std::cin.ignore(10000, '\n');
+                    std::cout << "Diretorio de treino (ENTER = usar templates salvos): ";
+                    std::getline(std::cin, dirTreino);
+                    std::cout << "Diretorio de avaliacao: ";
+                    std::getline(std::cin, dirAvaliacao);
+                    avaliarEstrategiasOcr(trim(dirTreino), trim(dirAvaliacao));
+                    break;
+                }
+
+                case 9: {
+                    estresseCooldown();
+                    auto est = fachada.estatisticasAlertas();
+                    std::cout << "Alertas do servico: " << est.enviados << " enviados, " << est.escalados << " escalados, "
+                              << est.suprimidosCooldown << " em cooldown, " << est.suprimidosDuplicados << " duplicados\n";
+                    break;
+                }
             }
         } catch (const std::exception& e) {
             std::cout << "ERRO: " << e.what() << "\n";
         }
     }
 
-    running.store(false);
-    if (monitorThread.joinable()) monitorThread.join();
+    agendador.parar();
+    descoberta.parar();
+    fachada.pararNotificacoes();
+    SmtpEmailService::encerrarConexoes();
+    #ifdef USE_SQLITE3
+    historicoSQLite->flush();
+    #endif
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,257 @@
+#include "memory_repository.h"
+#include <stdexcept>
+#include <algorithm>
+
+// ==================== UsuarioRepositoryMemory ====================
+
+Usuario UsuarioRepositoryMemory::salvar(const Usuario& user) {
+    std::unique_lock<std::shared_mutex> lock(m);
+    if (user.id == 0) {
+        // INSERT (login é único, como na tabela TB_USUARIO)
+        if (porLogin.count(user.login)) {
+            throw std::runtime_error("Erro ao inserir usuario");
+        }
+        Usuario novo = user;
+        novo.id = proximoId++;
+        novo.hidrometros.clear();
+        porLogin[novo.login] = novo.id;
+        porId[novo.id] = novo;
+        return novo;
+    }
+
+    // UPDATE: só senha, perfil e email mudam
+    auto it = porId.find(user.id);
+    if (it != porId.end()) {
+        it->second.senhaHash = user.senhaHash;
+        it->second.perfil = user.perfil;
+        it->second.email = user.email;
+    }
+    return user;
+}
+
+std::optional<Usuario> UsuarioRepositoryMemory::buscarPorLogin(const std::string& login) {
+    std::shared_lock<std::shared_mutex> lock(m);
+    auto it = porLogin.find(login);
+    if (it == porLogin.end()) return std::nullopt;
+    return porId.at(it->second);
+}
+
+std::optional<Usuario> UsuarioRepositoryMemory::buscarPorId(int id) {
+    std::shared_lock<std::shared_mutex> lock(m);
+    auto it = porId.find(id);
+    if (it == porId.end()) return std::nullopt;
+    return it->second;
+}
+
+void UsuarioRepositoryMemory::deletar(int id) {
+    std::unique_lock<std::shared_mutex> lock(m);
+    auto it = porId.find(id);
+    if (it == porId.end()) return;
+    porLogin.erase(it->second.login);
+    porId.erase(it);
+}
+
+void UsuarioRepositoryMemory::vincularHidrometro(int userId, const std::string& idSHA) {
+    std::unique_lock<std::shared_mutex> lock(m);
+    auto it = porId.find(userId);
+    if (it == porId.end()) {
+        throw std::runtime_error("Erro ao vincular hidrometro");
+    }
+    it->second.hidrometros.push_back(idSHA);
+}
+
+void UsuarioRepositoryMemory::desvincularHidrometro(int userId, const std::string& idSHA) {
+    std::unique_lock<std::shared_mutex> lock(m);
+    auto it = porId.find(userId);
+    if (it == porId.end()) return;
+    auto& shas = it->second.hidrometros;
+    shas.erase(std::remove(shas.begin(), shas.end(), idSHA), shas.end());
+}
+
+std::vector<Usuario> UsuarioRepositoryMemory::listarTodosUsuarios() {
+    std::vector<Usuario> usuarios;
+    {
+        std::shared_lock<std::shared_mutex> lock(m);
+        usuarios.reserve(porId.size());
+        for (const auto& [id, user] : porId) usuarios.push_back(user);
+    }
+    // Mesma ordem do repositório SQLite
+    std::sort(usuarios.begin(), usuarios.end(), [](const Usuario& a, const Usuario& b) { return a.id < b.id; });
+    return usuarios;
+}
+
+// ==================== HistoricoRepositoryMemory ====================
+
+// Percorre o ring na ordem (data, id) decrescente, a partir do cursor do
+// filtro. Caso normal (datas em ordem de inserção): busca binária pelo fim do
+// intervalo/cursor e caminha para trás até `inicio`, sem alocar. Se alguma data
+// fora de ordem ainda está no ring, ordena os candidatos antes. `visita`
+// devolve false para parar.
+template <typename T, typename Visita>
+static void varrerDecrescente(const RingHistorico<T>& ring, const FiltroHistorico& filtro, Visita visita) {
+    auto antesDoFim = [&](const T& item) {
+        if (item.data >= filtro.fim) return false;
+        if (filtro.aposId <= 0) return true;
+        return item.data < filtro.aposData || (item.data == filtro.aposData && item.id < filtro.aposId);
+    };
+
+    if (ring.ordenado()) {
+        size_t lo = 0, hi = ring.size();
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (antesDoFim(ring[mid])) lo = mid + 1; else hi = mid;
+        }
+        for (size_t i = lo; i-- > 0;) {
+            const T& item = ring[i];
+            if (item.data < filtro.inicio || !visita(item)) break;
+        }
+        return;
+    }
+
+    std::vector<const T*> candidatos;
+    for (size_t i = 0; i < ring.size(); ++i) {
+        const T& item = ring[i];
+        if (item.data < filtro.inicio || !antesDoFim(item)) continue;
+        candidatos.push_back(&item);
+    }
+    std::sort(candidatos.begin(), candidatos.end(), [](const T* a, const T* b) {
+        return a->data != b->data ? a->data > b->data : a->id > b->id;
+    });
+    for (const T* item : candidatos) {
+        if (!visita(*item)) break;
+    }
+}
+
+HistoricoRepositoryMemory::HistoricoRepositoryMemory(size_t capacidade) : capacidadePorUsuario(capacidade) {}
+
+HistoricoRepositoryMemory::DadosUsuario& HistoricoRepositoryMemory::dadosDe(Shard& shard, int userId) {
+    auto it = shard.usuarios.find(userId);
+    if (it == shard.usuarios.end()) {
+        it = shard.usuarios.emplace(userId, DadosUsuario(capacidadePorUsuario)).first;
+    }
+    return it->second;
+}
+
+void HistoricoRepositoryMemory::salvarLeitura(const Leitura& leitura) {
+    Leitura nova = leitura;
+    Shard& shard = shardDe(leitura.userId);
+    std::unique_lock<std::shared_mutex> lock(shard.m);
+    // Id gerado sob o lock do shard: dentro de cada ring os ids ficam crescentes
+    nova.id = proximoIdLeitura.fetch_add(1, std::memory_order_relaxed);
+    dadosDe(shard, leitura.userId).leituras.push(std::move(nova));
+}
+
+void HistoricoRepositoryMemory::salvarAlerta(const AlertaRecord& alerta) {
+    AlertaRecord novo = alerta;
+    Shard& shard = shardDe(alerta.userId);
+    std::unique_lock<std::shared_mutex> lock(shard.m);
+    novo.id = proximoIdAlerta.fetch_add(1, std::memory_order_relaxed);
+    dadosDe(shard, alerta.userId).alertas.push(std::move(novo));
+}
+
+std::vector<AlertaRecord> HistoricoRepositoryMemory::listarAlertasPorUsuario(int userId) {
+    FiltroHistorico filtro;
+    filtro.userId = userId;
+    filtro.limite = 0;
+    return listarAlertasPaginado(filtro).itens;
+}
+
+int HistoricoRepositoryMemory::salvarRegra(int userId, const std::string& tipo, double valor, int extra) {
+    int id = proximoIdRegra.fetch_add(1, std::memory_order_relaxed);
+    Shard& shard = shardDe(userId);
+    std::unique_lock<std::shared_mutex> lock(shard.m);
+    dadosDe(shard, userId).regras.emplace_back(id, userId, tipo, valor, extra);
+    return id;
+}
+
+std::vector<std::tuple<int, int, std::string, double, int>> HistoricoRepositoryMemory::listarRegrasPorUsuario(int userId) {
+    Shard& shard = shardDe(userId);
+    std::shared_lock<std::shared_mutex> lock(shard.m);
+    auto it = shard.usuarios.find(userId);
+    if (it == shard.usuarios.end()) return {};
+    return it->second.regras;
+}
+
+std::vector<Leitura> HistoricoRepositoryMemory::listarLeiturasPorUsuario(int userId, int limit) {
+    FiltroHistorico filtro;
+    filtro.userId = userId;
+    filtro.limite = limit;
+    return listarLeiturasPaginado(filtro).itens;
+}
+
+Pagina<Leitura> HistoricoRepositoryMemory::listarLeiturasPaginado(const FiltroHistorico& filtro) {
+    Pagina<Leitura> pagina;
+    Shard& shard = shardDe(filtro.userId);
+    std::shared_lock<std::shared_mutex> lock(shard.m);
+    auto it = shard.usuarios.find(filtro.userId);
+    if (it == shard.usuarios.end()) return pagina;
+
+    varrerDecrescente(it->second.leituras, filtro, [&](const Leitura& l) {
+        if (filtro.idSHA && l.idSHA != *filtro.idSHA) return true;
+        pagina.itens.push_back(l);
+        return filtro.limite <= 0 || pagina.itens.size() < static_cast<size_t>(filtro.limite);
+    });
+    if (filtro.limite > 0 && pagina.itens.size() == static_cast<size_t>(filtro.limite)) {
+        pagina.proximoData = pagina.itens.back().data;
+        pagina.proximoId = pagina.itens.back().id;
+    }
+    return pagina;
+}
+
+Pagina<AlertaRecord> HistoricoRepositoryMemory::listarAlertasPaginado(const FiltroHistorico& filtro) {
+    Pagina<AlertaRecord> pagina;
+    Shard& shard = shardDe(filtro.userId);
+    std::shared_lock<std::shared_mutex> lock(shard.m);
+    auto it = shard.usuarios.find(filtro.userId);
+    if (it == shard.usuarios.end()) return pagina;
+
+    varrerDecrescente(it->second.alertas, filtro, [&](const AlertaRecord& a) {
+        pagina.itens.push_back(a);
+        return filtro.limite <= 0 || pagina.itens.size() < static_cast<size_t>(filtro.limite);
+    });
+    if (filtro.limite > 0 && pagina.itens.size() == static_cast<size_t>(filtro.limite)) {
+        pagina.proximoData = pagina.itens.back().data;
+        pagina.proximoId = pagina.itens.back().id;
+    }
+    return pagina;
+}
+
+void HistoricoRepositoryMemory::percorrerLeituras(const FiltroHistorico& filtro, const VisitanteLeitura& visitante) {
+    Shard& shard = shardDe(filtro.userId);
+    std::shared_lock<std::shared_mutex> lock(shard.m);
+    auto it = shard.usuarios.find(filtro.userId);
+    if (it == shard.usuarios.end()) return;
+
+    size_t entregues = 0;
+    LeituraView linha;
+    varrerDecrescente(it->second.leituras, filtro, [&](const Leitura& l) {
+        if (filtro.idSHA && l.idSHA != *filtro.idSHA) return true;
+        linha.id = l.id;
+        linha.userId = l.userId;
+        linha.idSHA = l.idSHA;
+        linha.data = l.data;
+        linha.valor = l.valor;
+        linha.caminhoImagem = l.caminhoImagem;
+        if (!visitante(linha)) return false;
+        return filtro.limite <= 0 || ++entregues < static_cast<size_t>(filtro.limite);
+    });
+}
+
+void HistoricoRepositoryMemory::percorrerAlertas(const FiltroHistorico& filtro, const VisitanteAlerta& visitante) {
+    Shard& shard = shardDe(filtro.userId);
+    std::shared_lock<std::shared_mutex> lock(shard.m);
+    auto it = shard.usuarios.find(filtro.userId);
+    if (it == shard.usuarios.end()) return;
+
+    size_t entregues = 0;
+    AlertaView linha;
+    varrerDecrescente(it->second.alertas, filtro, [&](const AlertaRecord& a) {
+        linha.id = a.id;
+        linha.userId = a.userId;
+        linha.consumo = a.consumo;
+        linha.mensagem = a.mensagem;
+        linha.data = a.data;
+        if (!visitante(linha)) return false;
+        return filtro.limite <= 0 || ++entregues < static_cast<size_t>(filtro.limite);
+    });
+}
@@ -0,0 +1,127 @@
+#ifndef MEMORY_REPOSITORY_H
+#define MEMORY_REPOSITORY_H
+
+#include "core.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <atomic>
+#include <array>
+#include <tuple>
+
+// Buffer circular que cresce sob demanda até a capacidade e depois sobrescreve
+// o item mais antigo. Índice lógico 0 = mais antigo.
+template <typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t cap) : capacidade(cap > 0 ? cap : 1) {}
+
+    void push(T item) {
+        if (buf.size() < capacidade) {
+            buf.push_back(std::move(item));
+        } else {
+            buf[inicio] = std::move(item);
+            inicio = (inicio + 1) % capacidade;
+        }
+    }
+    size_t size() const { return buf.size(); }
+    bool empty() const { return buf.empty(); }
+    bool cheio() const { return buf.size() == capacidade; }
+    const T& operator[](size_t i) const { return buf[(inicio + i) % buf.size()]; }
+
+private:
+    std::vector<T> buf;
+    size_t capacidade;
+    size_t inicio = 0;
+};
+
+// Ring de histórico (itens com `data` e `id`) que sabe se está em ordem
+// (data, id) crescente. Os ids já crescem na inserção; basta contar os pares
+// vizinhos com data decrescente, atualizados em O(1) a cada push e descarte.
+template <typename T>
+class RingHistorico {
+public:
+    explicit RingHistorico(size_t cap) : ring(cap) {}
+
+    void push(T item) {
+        bool descarta = ring.cheio(); // o mais antigo sai e leva o par (0, 1)
+        if (descarta && ring.size() > 1 && ring[1].data < ring[0].data) inversoes--;
+        if (ring.size() > (descarta ? 1u : 0u) && item.data < ring[ring.size() - 1].data) inversoes++;
+        ring.push(std::move(item));
+    }
+    size_t size() const { return ring.size(); }
+    const T& operator[](size_t i) const { return ring[i]; }
+    bool ordenado() const { return inversoes == 0; }
+
+private:
+    RingBuffer<T> ring;
+    size_t inversoes = 0;
+};
+
+// Repositório de usuários em memória: índices hash por id e por login.
+class UsuarioRepositoryMemory : public IUsuarioRepository {
+private:
+    std::unordered_map<int, Usuario> porId;
+    std::unordered_map<std::string, int> porLogin;
+    int proximoId = 1;
+    mutable std::shared_mutex m;
+
+public:
+    Usuario salvar(const Usuario& user) override;
+    std::optional<Usuario> buscarPorLogin(const std::string& login) override;
+    std::optional<Usuario> buscarPorId(int id) override;
+    void deletar(int id) override;
+    void vincularHidrometro(int userId, const std::string& idSHA) override;
+    void desvincularHidrometro(int userId, const std::string& idSHA) override;
+    std::vector<Usuario> listarTodosUsuarios() override;
+};
+
+// Histórico em memória: cada usuário tem ring buffers de leituras e alertas
+// (os mais antigos são descartados ao atingir a capacidade). Os usuários são
+// distribuídos em shards com lock próprio para que threads diferentes não
+// disputem o mesmo mutex.
+class HistoricoRepositoryMemory : public IHistoricoRepository {
+private:
+    using Regra = std::tuple<int, int, std::string, double, int>;
+
+    struct DadosUsuario {
+        RingHistorico<Leitura> leituras;
+        RingHistorico<AlertaRecord> alertas;
+        std::vector<Regra> regras;
+        explicit DadosUsuario(size_t cap) : leituras(cap), alertas(cap) {}
+    };
+
+    struct Shard {
+        std::unordered_map<int, DadosUsuario> usuarios;
+        mutable std::shared_mutex m;
+    };
+
+    static constexpr size_t NUM_SHARDS = 16;
+    std::array<Shard, NUM_SHARDS> shards;
+    size_t capacidadePorUsuario;
+    std::atomic<int> proximoIdLeitura{1};
+    std::atomic<int> proximoIdAlerta{1};
+    std::atomic<int> proximoIdRegra{1};
+
+    Shard& shardDe(int userId) { return shards[static_cast<size_t>(userId) % NUM_SHARDS]; }
+    DadosUsuario& dadosDe(Shard& shard, int userId);
+
+public:
+    explicit HistoricoRepositoryMemory(size_t capacidadePorUsuario = 10000);
+
+    void salvarLeitura(const Leitura& leitura) override;
+    void salvarAlerta(const AlertaRecord& alerta) override;
+    std::vector<AlertaRecord> listarAlertasPorUsuario(int userId) override;
+    int salvarRegra(int userId, const std::string& tipo, double valor, int extra = 0) override;
+    std::vector<std::tuple<int, int, std::string, double, int>> listarRegrasPorUsuario(int userId) override;
+    std::vector<Leitura> listarLeiturasPorUsuario(int userId, int limit = 10) override;
+    Pagina<Leitura> listarLeiturasPaginado(const FiltroHistorico& filtro) override;
+    Pagina<AlertaRecord> listarAlertasPaginado(const FiltroHistorico& filtro) override;
+    // Segura o lock de leitura do shard durante a varredura
+    void percorrerLeituras(const FiltroHistorico& filtro, const VisitanteLeitura& visitante) override;
+    void percorrerAlertas(const FiltroHistorico& filtro, const VisitanteAlerta& visitante) override;
+};
+
+#endif // MEMORY_REPOSITORY_H
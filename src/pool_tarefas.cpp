@@ -0,0 +1,102 @@
+#include "pool_tarefas.h"
+#include <algorithm>
+
+PoolTarefas* PoolTarefas::instance = nullptr;
+std::mutex PoolTarefas::instanceMutex;
+
+// Worker em que a thread atual roda (nullptr fora do pool)
+static thread_local PoolTarefas* poolAtual = nullptr;
+static thread_local size_t indiceAtual = 0;
+
+PoolTarefas& PoolTarefas::getInstance() {
+    std::lock_guard<std::mutex> lock(instanceMutex);
+    if (!instance) instance = new PoolTarefas();
+    return *instance;
+}
+
+PoolTarefas::PoolTarefas(size_t numThreads) {
+    if (numThreads == 0) numThreads = std::max(2u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < numThreads; ++i) filas.push_back(std::make_unique<Fila>());
+    for (size_t i = 0; i < numThreads; ++i) threads.emplace_back(&PoolTarefas::loopWorker, this, i);
+}
+
+PoolTarefas::~PoolTarefas() {
+    {
+        std::lock_guard<std::mutex> lock(sonoM);
+        parando = true;
+    }
+    sonoCv.notify_all();
+    for (auto& t : threads) {
+        if (t.joinable()) t.join();
+    }
+}
+
+void PoolTarefas::enfileirar(Tarefa t) {
+    Fila& destino = poolAtual == this ? *filas[indiceAtual] : global;
+    {
+        // Contagem sob a trava da fila: pendentes nunca fica abaixo do que há nas filas
+        std::lock_guard<std::mutex> lock(destino.m);
+        destino.tarefas.push_back(std::move(t));
+        pendentes++;
+    }
+    // sonoM só quando há worker dormindo. O worker incrementa `dormindo` antes
+    // de testar `pendentes` (ambos seq_cst): ou ele vê a tarefa nova, ou nós o
+    // vemos dormindo e o acordamos sob a trava, sem perder o aviso.
+    if (dormindo.load() > 0) {
+        { std::lock_guard<std::mutex> lockSono(sonoM); }
+        sonoCv.notify_one();
+    }
+}
+
+bool PoolTarefas::pegarTarefa(size_t indice, Tarefa& t) {
+    auto tirar = [&](Fila& f, bool doFim) {
+        std::lock_guard<std::mutex> lock(f.m);
+        if (f.tarefas.empty()) return false;
+        if (doFim) {
+            t = std::move(f.tarefas.back());
+            f.tarefas.pop_back();
+        } else {
+            t = std::move(f.tarefas.front());
+            f.tarefas.pop_front();
+        }
+        pendentes--;
+        return true;
+    };
+
+    if (pendentes.load() == 0) return false;
+    if (tirar(*filas[indice], true)) return true;
+    if (tirar(global, false)) return true;
+    const size_t n = filas.size();
+    const size_t inicio = indice + 1;
+    for (size_t k = 0; k < n; ++k) {
+        size_t vitima = (inicio + k) % n;
+        if (vitima == indice) continue;
+        if (tirar(*filas[vitima], false)) {
+            roubadas++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PoolTarefas::loopWorker(size_t indice) {
+    poolAtual = this;
+    indiceAtual = indice;
+    for (;;) {
+        Tarefa t;
+        if (pegarTarefa(indice, t)) {
+            t();
+            executadas++;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sonoM);
+        dormindo++;
+        sonoCv.wait(lock, [&] { return parando.load() || pendentes.load() > 0; });
+        dormindo--;
+        if (parando && pendentes.load() == 0) return;
+    }
+}
+
+PoolTarefas::Estatisticas PoolTarefas::estatisticas() const {
+    return {executadas.load(), roubadas.load(), ajudadas.load(), threads.size()};
+}
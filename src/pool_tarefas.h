@@ -0,0 +1,162 @@
+#ifndef POOL_TAREFAS_H
+#define POOL_TAREFAS_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+// Pool de threads do processo com roubo de tarefas. Cada worker tem sua
+// própria fila: tarefas submetidas de dentro de um worker entram na fila dele
+// (e saem em LIFO), as de fora entram numa fila global, e worker ocioso rouba
+// do início da fila dos outros.
+//
+// Quem espera os próprios filhos submete por um GrupoTarefas e espera com
+// GrupoTarefas::aguardar, que executa na hora os filhos que nenhum worker
+// pegou ainda. Assim um composite aninhado que espera de dentro de um worker
+// nunca prende o pool, e nunca pega trabalho alheio (um ciclo inteiro do
+// agendador, p.ex.) que o faria estourar o prazo.
+class PoolTarefas {
+public:
+    using Tarefa = std::function<void()>;
+
+    struct Estatisticas {
+        uint64_t executadas = 0;
+        uint64_t roubadas = 0;   // tiradas da fila de outro worker
+        uint64_t ajudadas = 0;   // executadas por quem estava em GrupoTarefas::aguardar()
+        size_t threads = 0;
+    };
+
+    static PoolTarefas& getInstance();
+
+    explicit PoolTarefas(size_t numThreads = 0); // 0 = núcleos (mínimo 2)
+    ~PoolTarefas();
+    PoolTarefas(const PoolTarefas&) = delete;
+    PoolTarefas& operator=(const PoolTarefas&) = delete;
+
+    template <class F>
+    auto submeter(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        auto tarefa = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        auto futuro = tarefa->get_future();
+        enfileirar([tarefa]() { (*tarefa)(); });
+        return futuro;
+    }
+
+    size_t numeroThreads() const { return threads.size(); }
+    Estatisticas estatisticas() const;
+
+private:
+    friend class GrupoTarefas;
+
+    struct Fila {
+        std::mutex m;
+        std::deque<Tarefa> tarefas;
+    };
+
+    std::vector<std::unique_ptr<Fila>> filas; // uma por worker
+    Fila global;
+    std::vector<std::thread> threads;
+
+    std::mutex sonoM;
+    std::condition_variable sonoCv;
+    std::atomic<size_t> pendentes{0};
+    std::atomic<size_t> dormindo{0}; // workers dentro de sonoCv.wait
+    std::atomic<bool> parando{false};
+
+    std::atomic<uint64_t> executadas{0};
+    std::atomic<uint64_t> roubadas{0};
+    std::atomic<uint64_t> ajudadas{0};
+
+    static PoolTarefas* instance;
+    static std::mutex instanceMutex;
+
+    void enfileirar(Tarefa t);
+    bool pegarTarefa(size_t indice, Tarefa& t);
+    void loopWorker(size_t indice);
+};
+
+// Tarefas de um mesmo fan-out (os filhos de um composite, p.ex.). Cada tarefa
+// vai para o pool normalmente, mas quem a executar primeiro — um worker ou o
+// dono em aguardar() — a reivindica; a outra cópia vira no-op. aguardar() só
+// ajuda com tarefas deste grupo e não começa nenhuma depois do prazo.
+// O grupo precisa viver até o último aguardar(); tarefas expiradas seguem no pool.
+class GrupoTarefas {
+public:
+    explicit GrupoTarefas(PoolTarefas& pool) : pool(pool) {}
+    GrupoTarefas(const GrupoTarefas&) = delete;
+    GrupoTarefas& operator=(const GrupoTarefas&) = delete;
+
+    template <class F>
+    auto submeter(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        auto tarefa = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        auto futuro = tarefa->get_future();
+        auto item = std::make_shared<Item>();
+        item->executar = [tarefa]() { (*tarefa)(); };
+        {
+            std::lock_guard<std::mutex> lock(m);
+            itens.push_back(item);
+        }
+        pool.enfileirar([item]() { item->rodar(); });
+        return futuro;
+    }
+
+    // Espera o future até o prazo executando as tarefas do grupo que ainda não
+    // começaram. Retorna false se o prazo venceu antes do resultado ficar pronto
+    // (a tarefa continua e o resultado é descartado). Uma tarefa ajudada roda
+    // até o fim, mas é só um filho deste fan-out, nunca trabalho de outro.
+    template <class Futuro> // std::future ou std::shared_future
+    bool aguardar(Futuro& futuro, std::chrono::steady_clock::time_point prazo) {
+        using namespace std::chrono;
+        while (futuro.wait_for(seconds(0)) != std::future_status::ready) {
+            auto agora = steady_clock::now();
+            if (agora >= prazo) return false;
+            if (!executarUmaPropria()) futuro.wait_until(std::min(prazo, agora + milliseconds(1)));
+        }
+        return true;
+    }
+
+private:
+    struct Item {
+        std::atomic<bool> reivindicada{false};
+        std::function<void()> executar;
+        bool rodar() {
+            if (reivindicada.exchange(true)) return false;
+            executar();
+            executar = nullptr; // solta a tarefa (e o que ela captura) assim que termina
+            return true;
+        }
+    };
+
+    PoolTarefas& pool;
+    std::mutex m;
+    std::vector<std::shared_ptr<Item>> itens; // LIFO: a mais recente primeiro, como a fila do worker
+
+    bool executarUmaPropria() {
+        for (;;) {
+            std::shared_ptr<Item> item;
+            {
+                std::lock_guard<std::mutex> lock(m);
+                if (itens.empty()) return false;
+                item = std::move(itens.back());
+                itens.pop_back();
+            }
+            // O worker que depois tirar a cópia do pool conta a execução; aqui só a ajuda
+            if (item->rodar()) {
+                pool.ajudadas++;
+                return true;
+            }
+        }
+    }
+};
+
+#endif
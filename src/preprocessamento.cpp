@@ -0,0 +1,360 @@
+#include "preprocessamento.h"
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#ifdef USE_TESSERACT
+#include <leptonica/allheaders.h>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PREPROC_X86 1
+#include <immintrin.h>
+#define ALVO_SSE41 __attribute__((target("ssse3,sse4.1")))
+#define ALVO_AVX2 __attribute__((target("avx2")))
+#endif
+
+// ==================== DETECÇÃO DE CPU ====================
+ModoSimd detectarModoSimd() {
+#ifdef PREPROC_X86
+    static const ModoSimd modo = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return ModoSimd::AVX2;
+        if (__builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("ssse3")) return ModoSimd::SSE41;
+        return ModoSimd::ESCALAR;
+    }();
+    return modo;
+#else
+    return ModoSimd::ESCALAR;
+#endif
+}
+
+const char* nomeModoSimd(ModoSimd modo) {
+    switch (modo) {
+        case ModoSimd::AUTO: return nomeModoSimd(detectarModoSimd());
+        case ModoSimd::ESCALAR: return "escalar";
+        case ModoSimd::SSE41: return "SSE4.1";
+        case ModoSimd::AVX2: return "AVX2";
+    }
+    return "?";
+}
+
+// Pedido de um modo que a CPU não tem cai para o melhor disponível
+static ModoSimd resolverModo(ModoSimd pedido) {
+    ModoSimd disponivel = detectarModoSimd();
+    if (pedido == ModoSimd::AUTO) return disponivel;
+    return static_cast<int>(pedido) <= static_cast<int>(disponivel) ? pedido : disponivel;
+}
+
+// ==================== DECODIFICAÇÃO ====================
+static bool lerTokenNetpbm(std::istream& in, int& valor) {
+    char c;
+    while (in.get(c)) {
+        if (c == '#') { in.ignore(1 << 20, '\n'); continue; }
+        if (!std::isspace(static_cast<unsigned char>(c))) { in.unget(); break; }
+    }
+    return static_cast<bool>(in >> valor);
+}
+
+static bool decodificarNetpbm(const std::string& caminho, Imagem& saida) {
+    std::ifstream in(caminho, std::ios::binary);
+    char magica[2];
+    if (!in.read(magica, 2) || magica[0] != 'P' || (magica[1] != '5' && magica[1] != '6')) return false;
+
+    int largura, altura, maxval;
+    if (!lerTokenNetpbm(in, largura) || !lerTokenNetpbm(in, altura) || !lerTokenNetpbm(in, maxval)) return false;
+    if (largura <= 0 || altura <= 0 || maxval <= 0 || maxval > 255) return false;
+    in.get(); // um único espaço separa o cabeçalho dos dados
+
+    saida.largura = largura;
+    saida.altura = altura;
+    saida.canais = magica[1] == '6' ? 3 : 1;
+    saida.pixels.resize(static_cast<size_t>(largura) * altura * saida.canais);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(saida.pixels.data()), saida.pixels.size()));
+}
+
+bool decodificarImagem(const std::string& caminho, Imagem& saida) {
+    if (decodificarNetpbm(caminho, saida)) return true;
+#ifdef USE_TESSERACT
+    Pix* lida = pixRead(caminho.c_str());
+    if (!lida) return false;
+    Pix* rgb = pixConvertTo32(lida);
+    pixDestroy(&lida);
+    if (!rgb) return false;
+
+    saida.largura = static_cast<int>(pixGetWidth(rgb));
+    saida.altura = static_cast<int>(pixGetHeight(rgb));
+    saida.canais = 3;
+    saida.pixels.resize(static_cast<size_t>(saida.largura) * saida.altura * 3);
+    const l_uint32* dados = pixGetData(rgb);
+    int wpl = pixGetWpl(rgb);
+    uint8_t* dst = saida.pixels.data();
+    for (int y = 0; y < saida.altura; ++y) {
+        const l_uint32* linha = dados + static_cast<size_t>(y) * wpl;
+        for (int x = 0; x < saida.largura; ++x) {
+            *dst++ = static_cast<uint8_t>(linha[x] >> L_RED_SHIFT);
+            *dst++ = static_cast<uint8_t>(linha[x] >> L_GREEN_SHIFT);
+            *dst++ = static_cast<uint8_t>(linha[x] >> L_BLUE_SHIFT);
+        }
+    }
+    pixDestroy(&rgb);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool salvarPgm(const std::string& caminho, const Imagem& imagem) {
+    if (imagem.vazia() || imagem.canais != 1) return false;
+    std::ofstream out(caminho, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out << "P5\n" << imagem.largura << " " << imagem.altura << "\n255\n";
+    out.write(reinterpret_cast<const char*>(imagem.pixels.data()), imagem.pixels.size());
+    return static_cast<bool>(out);
+}
+
+// ==================== RECORTE ====================
+Imagem recortarImagem(const Imagem& origem, const RegiaoInteresse& roi) {
+    int x0 = 0, y0 = 0, x1 = origem.largura, y1 = origem.altura;
+    if (!roi.vazia()) {
+        x0 = std::clamp(roi.x, 0, origem.largura);
+        y0 = std::clamp(roi.y, 0, origem.altura);
+        x1 = std::clamp(roi.x + roi.largura, x0, origem.largura);
+        y1 = std::clamp(roi.y + roi.altura, y0, origem.altura);
+    }
+
+    Imagem r;
+    r.largura = x1 - x0;
+    r.altura = y1 - y0;
+    r.canais = origem.canais;
+    size_t bytesLinha = static_cast<size_t>(r.largura) * r.canais;
+    r.pixels.resize(bytesLinha * r.altura);
+    for (int y = 0; y < r.altura; ++y) {
+        const uint8_t* src = origem.pixels.data() + (static_cast<size_t>(y0 + y) * origem.largura + x0) * origem.canais;
+        std::memcpy(r.pixels.data() + y * bytesLinha, src, bytesLinha);
+    }
+    return r;
+}
+
+// ==================== TONS DE CINZA ====================
+// Luma BT.601 em ponto fixo: (77 R + 150 G + 29 B) >> 8. A soma máxima
+// (255 * 256) cabe em 16 bits sem sinal, então os kernels SIMD trabalham em
+// epi16 e dão o mesmo resultado do escalar.
+static void cinzaEscalar(const uint8_t* rgb, uint8_t* cinza, size_t n) {
+    for (size_t i = 0; i < n; ++i, rgb += 3) {
+        cinza[i] = static_cast<uint8_t>((77u * rgb[0] + 150u * rgb[1] + 29u * rgb[2]) >> 8);
+    }
+}
+
+#ifdef PREPROC_X86
+// Separa 16 pixels RGB intercalados (48 bytes) em três vetores R, G e B
+ALVO_SSE41 static inline void separarRgb16(const uint8_t* p, __m128i& r, __m128i& g, __m128i& b) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+
+    r = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(a, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(m, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+            _mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+    g = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(a, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(m, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+            _mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+    b = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(a, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(m, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+            _mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+}
+
+ALVO_SSE41 static inline __m128i lumaEpi16(__m128i r, __m128i g, __m128i b) {
+    __m128i s = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(77)), _mm_mullo_epi16(g, _mm_set1_epi16(150)));
+    s = _mm_add_epi16(s, _mm_mullo_epi16(b, _mm_set1_epi16(29)));
+    return _mm_srli_epi16(s, 8);
+}
+
+ALVO_SSE41 static void cinzaSse41(const uint8_t* rgb, uint8_t* cinza, size_t n) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i r, g, b;
+        separarRgb16(rgb + i * 3, r, g, b);
+        __m128i lo = lumaEpi16(_mm_unpacklo_epi8(r, zero), _mm_unpacklo_epi8(g, zero), _mm_unpacklo_epi8(b, zero));
+        __m128i hi = lumaEpi16(_mm_unpackhi_epi8(r, zero), _mm_unpackhi_epi8(g, zero), _mm_unpackhi_epi8(b, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(cinza + i), _mm_packus_epi16(lo, hi));
+    }
+    cinzaEscalar(rgb + i * 3, cinza + i, n - i);
+}
+
+ALVO_AVX2 static void cinzaAvx2(const uint8_t* rgb, uint8_t* cinza, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i r, g, b;
+        separarRgb16(rgb + i * 3, r, g, b);
+        __m256i s = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_cvtepu8_epi16(r), _mm256_set1_epi16(77)),
+                                     _mm256_mullo_epi16(_mm256_cvtepu8_epi16(g), _mm256_set1_epi16(150)));
+        s = _mm256_add_epi16(s, _mm256_mullo_epi16(_mm256_cvtepu8_epi16(b), _mm256_set1_epi16(29)));
+        s = _mm256_srli_epi16(s, 8);
+        __m128i y = _mm_packus_epi16(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(cinza + i), y);
+    }
+    cinzaEscalar(rgb + i * 3, cinza + i, n - i);
+}
+#endif
+
+void converterParaCinza(const Imagem& origem, Imagem& cinza, ModoSimd modo) {
+    cinza.largura = origem.largura;
+    cinza.altura = origem.altura;
+    cinza.canais = 1;
+    size_t n = static_cast<size_t>(origem.largura) * origem.altura;
+    cinza.pixels.resize(n);
+    if (origem.canais == 1) {
+        std::memcpy(cinza.pixels.data(), origem.pixels.data(), n);
+        return;
+    }
+
+    switch (resolverModo(modo)) {
+#ifdef PREPROC_X86
+        case ModoSimd::AVX2: cinzaAvx2(origem.pixels.data(), cinza.pixels.data(), n); return;
+        case ModoSimd::SSE41: cinzaSse41(origem.pixels.data(), cinza.pixels.data(), n); return;
+#endif
+        default: cinzaEscalar(origem.pixels.data(), cinza.pixels.data(), n); return;
+    }
+}
+
+// ==================== LIMIAR ADAPTATIVO ====================
+// Imagem integral (largura+1) x (altura+1): a soma de qualquer janela sai de
+// quatro leituras. Para não dividir, a comparação é feita multiplicada pela
+// área: pixel*area + deslocamento*area > soma  =>  fundo (255).
+static void imagemIntegral(const Imagem& cinza, std::vector<uint32_t>& integral) {
+    const int w = cinza.largura, h = cinza.altura;
+    const size_t stride = static_cast<size_t>(w) + 1;
+    integral.assign(stride * (h + 1), 0);
+    for (int y = 0; y < h; ++y) {
+        const uint8_t* linha = cinza.pixels.data() + static_cast<size_t>(y) * w;
+        const uint32_t* acima = integral.data() + static_cast<size_t>(y) * stride;
+        uint32_t* atual = integral.data() + static_cast<size_t>(y + 1) * stride;
+        uint32_t somaLinha = 0;
+        for (int x = 0; x < w; ++x) {
+            somaLinha += linha[x];
+            atual[x + 1] = acima[x + 1] + somaLinha;
+        }
+    }
+}
+
+struct LinhaLimiar {
+    const uint8_t* pix;
+    uint8_t* saida;
+    const uint32_t* topo;  // linha y0 da integral
+    const uint32_t* base;  // linha y1+1 da integral
+    int alturaJanela;
+};
+
+static void limiarLinhaEscalar(const LinhaLimiar& l, int xIni, int xFim, int w, int raio, int deslocamento) {
+    for (int x = xIni; x < xFim; ++x) {
+        int x0 = std::max(0, x - raio);
+        int x1 = std::min(w - 1, x + raio);
+        int32_t area = (x1 - x0 + 1) * l.alturaJanela;
+        int32_t soma = static_cast<int32_t>(l.base[x1 + 1] - l.topo[x1 + 1] - l.base[x0] + l.topo[x0]);
+        l.saida[x] = (l.pix[x] * area + deslocamento * area > soma) ? 255 : 0;
+    }
+}
+
+#ifdef PREPROC_X86
+// Miolo da linha (janela inteira na horizontal): área constante, quatro cargas contíguas
+ALVO_SSE41 static int limiarLinhaSse41(const LinhaLimiar& l, int xIni, int xFim, int raio, int deslocamento) {
+    const int32_t area = (2 * raio + 1) * l.alturaJanela;
+    const __m128i vArea = _mm_set1_epi32(area);
+    const __m128i vDesl = _mm_set1_epi32(deslocamento * area);
+    int x = xIni;
+    for (; x + 4 <= xFim; x += 4) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l.base + x + raio + 1));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l.topo + x + raio + 1));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l.base + x - raio));
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l.topo + x - raio));
+        __m128i soma = _mm_add_epi32(_mm_sub_epi32(_mm_sub_epi32(d, c), b), a);
+
+        int32_t quatro;
+        std::memcpy(&quatro, l.pix + x, 4);
+        __m128i p = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(quatro));
+        __m128i lhs = _mm_add_epi32(_mm_mullo_epi32(p, vArea), vDesl);
+        __m128i m = _mm_cmpgt_epi32(lhs, soma);
+        m = _mm_packs_epi32(m, m);
+        m = _mm_packs_epi16(m, m);
+        quatro = _mm_cvtsi128_si32(m);
+        std::memcpy(l.saida + x, &quatro, 4);
+    }
+    return x;
+}
+
+ALVO_AVX2 static int limiarLinhaAvx2(const LinhaLimiar& l, int xIni, int xFim, int raio, int deslocamento) {
+    const int32_t area = (2 * raio + 1) * l.alturaJanela;
+    const __m256i vArea = _mm256_set1_epi32(area);
+    const __m256i vDesl = _mm256_set1_epi32(deslocamento * area);
+    int x = xIni;
+    for (; x + 8 <= xFim; x += 8) {
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(l.base + x + raio + 1));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(l.topo + x + raio + 1));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(l.base + x - raio));
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(l.topo + x - raio));
+        __m256i soma = _mm256_add_epi32(_mm256_sub_epi32(_mm256_sub_epi32(d, c), b), a);
+
+        __m256i p = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(l.pix + x)));
+        __m256i lhs = _mm256_add_epi32(_mm256_mullo_epi32(p, vArea), vDesl);
+        __m256i m = _mm256_cmpgt_epi32(lhs, soma);
+        __m128i m16 = _mm_packs_epi32(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(l.saida + x), _mm_packs_epi16(m16, m16));
+    }
+    return x;
+}
+#endif
+
+void limiarAdaptativo(const Imagem& cinza, Imagem& binaria, const ConfigLimiar& cfg, ModoSimd modo) {
+    const int w = cinza.largura, h = cinza.altura;
+    const int raio = std::max(0, cfg.raio);
+    binaria.largura = w;
+    binaria.altura = h;
+    binaria.canais = 1;
+    binaria.pixels.resize(static_cast<size_t>(w) * h);
+    if (cinza.vazia()) return;
+
+    std::vector<uint32_t> integral;
+    imagemIntegral(cinza, integral);
+    const size_t stride = static_cast<size_t>(w) + 1;
+    const ModoSimd efetivo = resolverModo(modo);
+
+    // Colunas [raio, w - raio) têm a janela horizontal completa
+    const int miolo0 = std::min(raio, w);
+    const int miolo1 = std::max(miolo0, w - raio);
+
+    for (int y = 0; y < h; ++y) {
+        int y0 = std::max(0, y - raio);
+        int y1 = std::min(h - 1, y + raio);
+        LinhaLimiar l{cinza.pixels.data() + static_cast<size_t>(y) * w,
+                      binaria.pixels.data() + static_cast<size_t>(y) * w,
+                      integral.data() + static_cast<size_t>(y0) * stride,
+                      integral.data() + static_cast<size_t>(y1 + 1) * stride,
+                      y1 - y0 + 1};
+
+        int x = miolo0;
+        switch (efetivo) {
+#ifdef PREPROC_X86
+            case ModoSimd::AVX2: x = limiarLinhaAvx2(l, miolo0, miolo1, raio, cfg.deslocamento); break;
+            case ModoSimd::SSE41: x = limiarLinhaSse41(l, miolo0, miolo1, raio, cfg.deslocamento); break;
+#endif
+            default: break;
+        }
+        limiarLinhaEscalar(l, 0, miolo0, w, raio, cfg.deslocamento);
+        limiarLinhaEscalar(l, x, w, w, raio, cfg.deslocamento);
+    }
+}
+
+// ==================== PIPELINE ====================
+Imagem preprocessarImagem(const Imagem& origem, const RegiaoInteresse& roi, const ConfigLimiar& cfg, ModoSimd modo) {
+    Imagem recorte = recortarImagem(origem, roi);
+    Imagem cinza;
+    converterParaCinza(recorte, cinza, modo);
+    Imagem binaria;
+    limiarAdaptativo(cinza, binaria, cfg, modo);
+    return binaria;
+}
@@ -0,0 +1,54 @@
+#ifndef PREPROCESSAMENTO_H
+#define PREPROCESSAMENTO_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Imagem com 8 bits por canal e linhas contíguas (canais: 1 = cinza, 3 = RGB)
+struct Imagem {
+    int largura = 0;
+    int altura = 0;
+    int canais = 0;
+    std::vector<uint8_t> pixels;
+
+    bool vazia() const { return largura <= 0 || altura <= 0; }
+};
+
+// Retângulo onde ficam os dígitos do hidrômetro; largura/altura 0 = imagem inteira
+struct RegiaoInteresse {
+    int x = 0;
+    int y = 0;
+    int largura = 0;
+    int altura = 0;
+
+    bool vazia() const { return largura <= 0 || altura <= 0; }
+};
+
+// Limiar adaptativo pela média local: pixel vira preto (dígito) quando fica
+// mais de `deslocamento` níveis abaixo da média da janela (2*raio+1)².
+struct ConfigLimiar {
+    int raio = 7;
+    int deslocamento = 10;
+};
+
+// Conjunto de kernels usado; AUTO escolhe o melhor suportado pela CPU em execução
+enum class ModoSimd { AUTO, ESCALAR, SSE41, AVX2 };
+
+ModoSimd detectarModoSimd();
+const char* nomeModoSimd(ModoSimd modo);
+
+// PGM/PPM (P5/P6) sempre; PNG/JPEG quando compilado com USE_TESSERACT (Leptonica)
+bool decodificarImagem(const std::string& caminho, Imagem& saida);
+bool salvarPgm(const std::string& caminho, const Imagem& imagem);
+
+// A região é recortada à área válida da imagem; região vazia copia a imagem inteira
+Imagem recortarImagem(const Imagem& origem, const RegiaoInteresse& roi);
+void converterParaCinza(const Imagem& origem, Imagem& cinza, ModoSimd modo = ModoSimd::AUTO);
+void limiarAdaptativo(const Imagem& cinza, Imagem& binaria, const ConfigLimiar& cfg, ModoSimd modo = ModoSimd::AUTO);
+
+// recorte -> cinza -> limiar; todos os modos produzem exatamente os mesmos pixels
+Imagem preprocessarImagem(const Imagem& origem, const RegiaoInteresse& roi, const ConfigLimiar& cfg,
+                          ModoSimd modo = ModoSimd::AUTO);
+
+#endif
@@ -0,0 +1,304 @@
+#include "reconhecedor_digitos.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define RECON_X86 1
+#include <immintrin.h>
+#define ALVO_SSE41 __attribute__((target("ssse3,sse4.1")))
+#define ALVO_AVX2 __attribute__((target("avx2")))
+#endif
+
+// ==================== CORRELAÇÃO ====================
+static float produtoEscalar(const float* a, const float* b) {
+    float s = 0.0f;
+    for (int i = 0; i < ReconhecedorDigitos::TAMANHO; ++i) s += a[i] * b[i];
+    return s;
+}
+
+#ifdef RECON_X86
+ALVO_SSE41 static float produtoEscalarSse41(const float* a, const float* b) {
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+    for (int i = 0; i < ReconhecedorDigitos::TAMANHO; i += 8) {
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    __m128 s = _mm_add_ps(s0, s1);
+    s = _mm_hadd_ps(s, s);
+    s = _mm_hadd_ps(s, s);
+    return _mm_cvtss_f32(s);
+}
+
+ALVO_AVX2 static float produtoEscalarAvx2(const float* a, const float* b) {
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+    for (int i = 0; i < ReconhecedorDigitos::TAMANHO; i += 16) {
+        s0 = _mm256_add_ps(s0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        s1 = _mm256_add_ps(s1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+    }
+    __m256 s = _mm256_add_ps(s0, s1);
+    __m128 r = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+    r = _mm_hadd_ps(r, r);
+    r = _mm_hadd_ps(r, r);
+    return _mm_cvtss_f32(r);
+}
+#endif
+
+float ReconhecedorDigitos::correlacao(const float* a, const float* b, ModoSimd modo) {
+    ModoSimd disponivel = detectarModoSimd();
+    if (modo == ModoSimd::AUTO || static_cast<int>(modo) > static_cast<int>(disponivel)) modo = disponivel;
+    switch (modo) {
+#ifdef RECON_X86
+        case ModoSimd::AVX2: return produtoEscalarAvx2(a, b);
+        case ModoSimd::SSE41: return produtoEscalarSse41(a, b);
+#endif
+        default: return produtoEscalar(a, b);
+    }
+}
+
+// ==================== SEGMENTAÇÃO ====================
+// O limiar adaptativo deixa pontos soltos no fundo; tinta com menos de dois
+// vizinhos (8-conectividade) é descartada antes de segmentar
+Imagem ReconhecedorDigitos::removerRuido(const Imagem& binaria) {
+    Imagem limpa = binaria;
+    const int w = binaria.largura, h = binaria.altura;
+    if (binaria.vazia() || binaria.canais != 1) return limpa;
+    const uint8_t* src = binaria.pixels.data();
+    for (int y = 0; y < h; ++y) {
+        const uint8_t* acima = y > 0 ? src + static_cast<size_t>(y - 1) * w : nullptr;
+        const uint8_t* linha = src + static_cast<size_t>(y) * w;
+        const uint8_t* abaixo = y + 1 < h ? src + static_cast<size_t>(y + 1) * w : nullptr;
+        for (int x = 0; x < w; ++x) {
+            if (linha[x] != 0) continue;
+            const int xa = std::max(0, x - 1), xb = std::min(w - 1, x + 1);
+            int vizinhos = -1; // o próprio pixel é contado na linha do meio
+            for (int k = xa; k <= xb; ++k) {
+                vizinhos += linha[k] == 0;
+                if (acima) vizinhos += acima[k] == 0;
+                if (abaixo) vizinhos += abaixo[k] == 0;
+            }
+            if (vizinhos < 2) limpa.pixels[static_cast<size_t>(y) * w + x] = 255;
+        }
+    }
+    return limpa;
+}
+
+// Projeção vertical: colunas com tinta formam faixas, e cada faixa é um dígito.
+// Faixas bem mais baixas que um dígito típico e encostadas na base viram ponto
+// decimal; as demais baixas são ruído.
+std::vector<SegmentoDigito> ReconhecedorDigitos::segmentar(const Imagem& binaria) {
+    std::vector<SegmentoDigito> segmentos;
+    const int w = binaria.largura, h = binaria.altura;
+    if (binaria.vazia() || binaria.canais != 1) return segmentos;
+
+    std::vector<int> tintaColuna(w, 0);
+    for (int y = 0; y < h; ++y) {
+        const uint8_t* linha = binaria.pixels.data() + static_cast<size_t>(y) * w;
+        for (int x = 0; x < w; ++x) tintaColuna[x] += linha[x] == 0;
+    }
+
+    // Coluna/linha só conta com pelo menos 2 pixels de tinta: resíduo de ruído
+    // não emenda dígitos vizinhos nem estica a caixa
+    std::vector<SegmentoDigito> faixas;
+    for (int x = 0; x < w;) {
+        if (tintaColuna[x] < 2) { ++x; continue; }
+        int x0 = x;
+        while (x < w && tintaColuna[x] >= 2) ++x;
+        SegmentoDigito s;
+        s.x = x0;
+        s.largura = x - x0;
+        // Altura = maior sequência de linhas com tinta (tolera 1 linha vazia),
+        // para que um resto de ruído acima/abaixo não estique a caixa
+        int y0 = 0, y1 = -1, inicio = -1, ultima = -1;
+        for (int y = 0; y <= h; ++y) {
+            bool temTinta = false;
+            if (y < h) {
+                const uint8_t* linha = binaria.pixels.data() + static_cast<size_t>(y) * w + x0;
+                temTinta = std::count(linha, linha + s.largura, 0) >= std::min(2, s.largura);
+            }
+            if (temTinta) {
+                if (inicio < 0 || y - ultima > 2) inicio = y;
+                ultima = y;
+                if (ultima - inicio > y1 - y0) { y0 = inicio; y1 = ultima; }
+            }
+        }
+        if (y1 < 0) continue;
+        s.y = y0;
+        s.altura = y1 - y0 + 1;
+        faixas.push_back(s);
+    }
+    if (faixas.empty()) return segmentos;
+
+    // Referência = faixa de altura mediana (os dígitos são maioria)
+    std::vector<SegmentoDigito> ordenadas = faixas;
+    std::nth_element(ordenadas.begin(), ordenadas.begin() + ordenadas.size() / 2, ordenadas.end(),
+                     [](const SegmentoDigito& a, const SegmentoDigito& b) { return a.altura < b.altura; });
+    const int alturaRef = ordenadas[ordenadas.size() / 2].altura;
+    const int baseRef = ordenadas[ordenadas.size() / 2].y + alturaRef;
+    for (auto f : faixas) {
+        if (f.altura * 5 >= alturaRef * 2) {
+            segmentos.push_back(f);
+        } else if (f.y + f.altura >= baseRef - alturaRef / 5 && f.largura * 2 <= alturaRef) {
+            f.ponto = true;
+            segmentos.push_back(f);
+        }
+    }
+    return segmentos;
+}
+
+// Escala pela altura preservando a proporção (um "1" não vira um bloco; só
+// dígitos largos demais são comprimidos na horizontal), centraliza na grade e
+// amostra 3x3 por célula; depois média zero e norma 1.
+bool ReconhecedorDigitos::normalizar(const Imagem& binaria, const SegmentoDigito& seg, Vetor& saida) {
+    const float escalaY = static_cast<float>(seg.altura) / ALTURA;
+    const float escalaX = std::max(escalaY, static_cast<float>(seg.largura) / LARGURA);
+    const float margem = (LARGURA - seg.largura / escalaX) / 2.0f;
+
+    // Coordenadas de origem das 3 amostras por célula, calculadas uma vez por eixo
+    int xs[LARGURA * 3], ys[ALTURA * 3], validasColuna[LARGURA] = {};
+    for (int i = 0; i < LARGURA * 3; ++i) {
+        float fx = ((i + 0.5f) / 3.0f - margem) * escalaX;
+        xs[i] = (fx < 0 || fx >= seg.largura) ? -1 : seg.x + static_cast<int>(fx);
+        validasColuna[i / 3] += xs[i] >= 0;
+    }
+    for (int j = 0; j < ALTURA * 3; ++j) {
+        ys[j] = seg.y + std::min(seg.altura - 1, static_cast<int>((j + 0.5f) / 3.0f * escalaY));
+    }
+
+    float soma = 0.0f;
+    for (int gy = 0; gy < ALTURA; ++gy) {
+        int tinta[LARGURA] = {};
+        for (int sy = 0; sy < 3; ++sy) {
+            const uint8_t* linha = binaria.pixels.data() + static_cast<size_t>(ys[gy * 3 + sy]) * binaria.largura;
+            for (int i = 0; i < LARGURA * 3; ++i) {
+                if (xs[i] >= 0) tinta[i / 3] += linha[xs[i]] == 0;
+            }
+        }
+        for (int gx = 0; gx < LARGURA; ++gx) {
+            float v = validasColuna[gx] ? static_cast<float>(tinta[gx]) / (validasColuna[gx] * 3) : 0.0f;
+            saida[gy * LARGURA + gx] = v;
+            soma += v;
+        }
+    }
+
+    const float media = soma / TAMANHO;
+    float norma = 0.0f;
+    for (auto& v : saida) {
+        v -= media;
+        norma += v * v;
+    }
+    if (norma <= 1e-6f) return false;
+    const float inv = 1.0f / std::sqrt(norma);
+    for (auto& v : saida) v *= inv;
+    return true;
+}
+
+// ==================== RECONHECIMENTO ====================
+ReconhecedorDigitos::Resultado ReconhecedorDigitos::reconhecer(const Imagem& binaria) const {
+    Resultado r;
+    if (templates.empty()) return r;
+    r.confianca = 1.0f;
+    Imagem limpa = removerRuido(binaria);
+    Vetor v;
+    for (const auto& seg : segmentar(limpa)) {
+        if (seg.ponto) {
+            if (r.texto.find('.') == std::string::npos && !r.texto.empty()) r.texto += '.';
+            continue;
+        }
+        if (!normalizar(limpa, seg, v)) continue;
+        float melhor = -2.0f;
+        char digito = '?';
+        for (const auto& t : templates) {
+            float c = correlacao(v.data(), t.v.data(), modo);
+            if (c > melhor) {
+                melhor = c;
+                digito = t.digito;
+            }
+        }
+        r.texto += digito;
+        r.confianca = std::min(r.confianca, melhor);
+    }
+    if (r.texto.empty()) r.confianca = 0.0f;
+    return r;
+}
+
+// ==================== TREINO E PERSISTÊNCIA ====================
+bool ReconhecedorDigitos::aprender(const Imagem& binaria, const std::string& rotulo) {
+    std::string esperado;
+    for (char c : rotulo) {
+        if ((c >= '0' && c <= '9') || c == '.') esperado += c;
+    }
+    Imagem limpa = removerRuido(binaria);
+    auto segmentos = segmentar(limpa);
+    if (segmentos.size() != esperado.size()) return false;
+    for (size_t i = 0; i < segmentos.size(); ++i) {
+        if (segmentos[i].ponto != (esperado[i] == '.')) return false;
+    }
+
+    Vetor v;
+    for (size_t i = 0; i < segmentos.size(); ++i) {
+        if (segmentos[i].ponto || !normalizar(limpa, segmentos[i], v)) continue;
+        int d = esperado[i] - '0';
+        if (somas[d].empty()) somas[d].assign(TAMANHO, 0.0);
+        for (int k = 0; k < TAMANHO; ++k) somas[d][k] += v[k];
+        amostras[d]++;
+    }
+    return true;
+}
+
+void ReconhecedorDigitos::finalizarTreino() {
+    for (int d = 0; d < 10; ++d) {
+        if (!amostras[d]) continue;
+        Template t;
+        t.digito = static_cast<char>('0' + d);
+        double norma = 0.0;
+        for (int k = 0; k < TAMANHO; ++k) norma += somas[d][k] * somas[d][k];
+        if (norma <= 0.0) continue;
+        double inv = 1.0 / std::sqrt(norma);
+        for (int k = 0; k < TAMANHO; ++k) t.v[k] = static_cast<float>(somas[d][k] * inv);
+
+        auto it = std::find_if(templates.begin(), templates.end(), [&](const Template& x) { return x.digito == t.digito; });
+        if (it != templates.end()) *it = t;
+        else templates.push_back(t);
+        somas[d].clear();
+        amostras[d] = 0;
+    }
+}
+
+// Formato: cabeçalho "TEMPLATES <largura> <altura>", depois uma linha por
+// template: o dígito seguido dos LARGURA*ALTURA valores
+bool ReconhecedorDigitos::salvar(const std::string& caminho) const {
+    std::ofstream out(caminho, std::ios::trunc);
+    if (!out) return false;
+    out << "TEMPLATES " << LARGURA << " " << ALTURA << "\n";
+    out.precision(7);
+    for (const auto& t : templates) {
+        out << t.digito;
+        for (float v : t.v) out << " " << v;
+        out << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+bool ReconhecedorDigitos::carregar(const std::string& caminho) {
+    std::ifstream in(caminho);
+    std::string cabecalho;
+    int largura = 0, altura = 0;
+    if (!(in >> cabecalho >> largura >> altura) || cabecalho != "TEMPLATES" || largura != LARGURA || altura != ALTURA) return false;
+
+    std::vector<Template> lidos;
+    std::string linha;
+    std::getline(in, linha);
+    while (std::getline(in, linha)) {
+        std::istringstream iss(linha);
+        Template t;
+        if (!(iss >> t.digito) || t.digito < '0' || t.digito > '9') continue;
+        int k = 0;
+        while (k < TAMANHO && iss >> t.v[k]) ++k;
+        if (k == TAMANHO) lidos.push_back(t);
+    }
+    if (lidos.empty()) return false;
+    templates = std::move(lidos);
+    return true;
+}
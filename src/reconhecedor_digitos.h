@@ -0,0 +1,69 @@
+#ifndef RECONHECEDOR_DIGITOS_H
+#define RECONHECEDOR_DIGITOS_H
+
+#include "preprocessamento.h"
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+// Caixa de um dígito (ou ponto decimal) encontrada na imagem binarizada
+struct SegmentoDigito {
+    int x = 0;
+    int y = 0;
+    int largura = 0;
+    int altura = 0;
+    bool ponto = false;
+};
+
+// Reconhecedor por templates para mostradores de fonte fixa (rodas de dígitos
+// dos simuladores analógicos). Cada dígito segmentado é normalizado para uma
+// grade fixa com média zero e norma 1, de modo que a correlação normalizada
+// com um template vira um simples produto escalar (kernels SSE4.1/AVX2).
+// Os templates são aprendidos de imagens rotuladas e salvos em texto.
+class ReconhecedorDigitos {
+public:
+    static constexpr int LARGURA = 16;
+    static constexpr int ALTURA = 24;
+    static constexpr int TAMANHO = LARGURA * ALTURA;
+
+    using Vetor = std::array<float, TAMANHO>;
+
+    struct Resultado {
+        std::string texto;       // dígitos e ponto, na ordem da esquerda para a direita
+        float confianca = 0.0f;  // menor correlação entre os dígitos reconhecidos
+    };
+
+    explicit ReconhecedorDigitos(ModoSimd modo = ModoSimd::AUTO) : modo(modo) {}
+
+    bool carregar(const std::string& caminho);
+    bool salvar(const std::string& caminho) const;
+    bool treinado() const { return !templates.empty(); }
+    size_t numeroTemplates() const { return templates.size(); }
+
+    // Treino: acumula os dígitos de uma imagem cujo texto é conhecido. Retorna
+    // false (e ignora a imagem) se a segmentação não bater com o rótulo.
+    bool aprender(const Imagem& binaria, const std::string& rotulo);
+    // Transforma o acumulado em um template médio por dígito
+    void finalizarTreino();
+
+    // Imagem binarizada (0 = tinta, 255 = fundo), como sai de preprocessarImagem
+    Resultado reconhecer(const Imagem& binaria) const;
+
+    static Imagem removerRuido(const Imagem& binaria);
+    static std::vector<SegmentoDigito> segmentar(const Imagem& binaria);
+    static bool normalizar(const Imagem& binaria, const SegmentoDigito& seg, Vetor& saida);
+    static float correlacao(const float* a, const float* b, ModoSimd modo = ModoSimd::AUTO);
+
+private:
+    struct Template {
+        char digito;
+        Vetor v;
+    };
+    ModoSimd modo;
+    std::vector<Template> templates;
+    std::array<std::vector<double>, 10> somas;  // acumuladores de treino por dígito
+    std::array<int, 10> amostras{};
+};
+
+#endif
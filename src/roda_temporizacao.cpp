@@ -0,0 +1,71 @@
+#include "roda_temporizacao.h"
+
+RodaTemporizacao::RodaTemporizacao(std::chrono::milliseconds resolucao, Relogio::time_point inicio)
+    : tick(resolucao.count() > 0 ? resolucao : std::chrono::milliseconds(1)), inicio(inicio) {}
+
+void RodaTemporizacao::agendar(const std::string& chave, Relogio::time_point prazo) {
+    // Arredonda para cima: nada vence antes do prazo pedido
+    uint64_t alvo = 0;
+    if (prazo > inicio) {
+        auto decorrido = std::chrono::duration_cast<std::chrono::milliseconds>(prazo - inicio).count();
+        alvo = static_cast<uint64_t>((decorrido + tick.count() - 1) / tick.count());
+    }
+    uint64_t geracao = proximaGeracao++;
+    ativos[chave] = geracao;
+    inserir(Entrada{chave, alvo, prazo, geracao});
+}
+
+bool RodaTemporizacao::cancelar(const std::string& chave) {
+    return ativos.erase(chave) > 0;
+}
+
+void RodaTemporizacao::inserir(Entrada e) {
+    if (e.tickAlvo < tickAtual) e.tickAlvo = tickAtual; // atrasada: sai no próximo tick processado
+    uint64_t delta = e.tickAlvo - tickAtual;
+    if (delta < SLOTS_N0) {
+        nivel0[e.tickAlvo % SLOTS_N0].push_back(std::move(e));
+    } else if (delta < SLOTS_N0 * SLOTS_N1) {
+        nivel1[(e.tickAlvo / SLOTS_N0) % SLOTS_N1].push_back(std::move(e));
+    } else {
+        excedente.push_back(std::move(e));
+    }
+}
+
+void RodaTemporizacao::redistribuir(std::vector<Entrada>& origem) {
+    std::vector<Entrada> entradas;
+    entradas.swap(origem);
+    for (auto& e : entradas) {
+        auto it = ativos.find(e.chave);
+        if (it != ativos.end() && it->second == e.geracao) inserir(std::move(e));
+    }
+}
+
+std::vector<RodaTemporizacao::Vencimento> RodaTemporizacao::avancar(Relogio::time_point agora) {
+    std::vector<Vencimento> vencidos;
+    if (agora < inicio) return vencidos;
+    const uint64_t alvo = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(agora - inicio).count() / tick.count());
+
+    for (; tickAtual <= alvo; ++tickAtual) {
+        if (tickAtual % SLOTS_N0 == 0) {
+            if (tickAtual % (SLOTS_N0 * SLOTS_N1) == 0) redistribuir(excedente);
+            redistribuir(nivel1[(tickAtual / SLOTS_N0) % SLOTS_N1]);
+        }
+
+        auto& slot = nivel0[tickAtual % SLOTS_N0];
+        if (slot.empty()) continue;
+        std::vector<Entrada> entradas;
+        entradas.swap(slot);
+        for (auto& e : entradas) {
+            auto it = ativos.find(e.chave);
+            if (it == ativos.end() || it->second != e.geracao) continue; // cancelada ou reagendada
+            if (e.tickAlvo > tickAtual) {
+                inserir(std::move(e));
+                continue;
+            }
+            ativos.erase(it);
+            vencidos.push_back(Vencimento{std::move(e.chave), e.prazo});
+        }
+    }
+    return vencidos;
+}
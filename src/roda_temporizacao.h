@@ -0,0 +1,65 @@
+#ifndef RODA_TEMPORIZACAO_H
+#define RODA_TEMPORIZACAO_H
+
+#include <string>
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+
+// Roda de temporização hierárquica (estilo kernel): agendar/cancelar são O(1)
+// e avançar custa O(ticks decorridos + vencidos), independente de quantas
+// chaves estão agendadas.
+//   nível 0: 256 slots de 1 tick
+//   nível 1: 64 slots de 256 ticks
+//   excedente: o que estiver além de 256*64 ticks, redistribuído a cada volta
+// Cancelamento é preguiçoso: cada chave tem uma geração e entradas antigas são
+// descartadas quando o slot é processado. Não é thread-safe; quem usa trava.
+class RodaTemporizacao {
+public:
+    using Relogio = std::chrono::steady_clock;
+
+    struct Vencimento {
+        std::string chave;
+        Relogio::time_point prazo;
+    };
+
+    explicit RodaTemporizacao(std::chrono::milliseconds resolucao = std::chrono::milliseconds(100),
+                              Relogio::time_point inicio = Relogio::now());
+
+    // Reagendar uma chave substitui o prazo anterior
+    void agendar(const std::string& chave, Relogio::time_point prazo);
+    bool cancelar(const std::string& chave);
+    // Processa os ticks até `agora` e devolve o que venceu (com o prazo pedido, para medir atraso)
+    std::vector<Vencimento> avancar(Relogio::time_point agora);
+
+    bool agendada(const std::string& chave) const { return ativos.count(chave) > 0; }
+    size_t tamanho() const { return ativos.size(); }
+    std::chrono::milliseconds resolucao() const { return tick; }
+
+private:
+    static constexpr uint64_t SLOTS_N0 = 256;
+    static constexpr uint64_t SLOTS_N1 = 64;
+
+    struct Entrada {
+        std::string chave;
+        uint64_t tickAlvo;
+        Relogio::time_point prazo;
+        uint64_t geracao;
+    };
+
+    std::chrono::milliseconds tick;
+    Relogio::time_point inicio;
+    uint64_t tickAtual = 0; // próximo tick a processar
+    uint64_t proximaGeracao = 1;
+    std::array<std::vector<Entrada>, SLOTS_N0> nivel0;
+    std::array<std::vector<Entrada>, SLOTS_N1> nivel1;
+    std::vector<Entrada> excedente;
+    std::unordered_map<std::string, uint64_t> ativos; // chave -> geração vigente
+
+    void inserir(Entrada e);
+    void redistribuir(std::vector<Entrada>& origem);
+};
+
+#endif
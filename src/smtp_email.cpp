@@ -1,20 +1,99 @@
 #include "smtp_email.h"
 #include <iostream>
+#include <iomanip>
 #include <sstream>
 #include <fstream>
 #include <filesystem>
 #include <cstring>
+#include <map>
+#include <vector>
+#include <mutex>
 
 #ifdef USE_CURL
 #include <curl/curl.h>
 #endif
 
+static std::atomic<uint64_t> emailsEnviados{0};
+static std::atomic<uint64_t> alertasEnviados{0};
+static std::atomic<uint64_t> resumosEnviados{0};
+static std::atomic<uint64_t> conexoesAbertas{0};
+static std::atomic<uint64_t> falhasEnvio{0};
+
 SmtpEmailService::SmtpEmailService(const std::string& server, int p, const std::string& fromAddr,
                                    const std::string& toAddr, const std::string& u, const std::string& pass, SecureMode mode, int targetUid)
     : smtpServer(server), port(p), from(fromAddr), to(toAddr), user(u), password(pass), secure(mode), targetUserId(targetUid) {
         // std::cout << "[DEBUG] SmtpEmailService registrado para User ID: " << targetUserId << std::endl;
     }
 
+#ifdef USE_CURL
+// ==================== POOL DE CONEXOES ====================
+// Handles CURL ociosos por servidor/usuário. O handle guarda a conexão aberta
+// (TCP, TLS e AUTH já feitos) e curl_easy_reset não a fecha, então o próximo
+// e-mail para o mesmo servidor só manda MAIL FROM/RCPT/DATA. O pool é do
+// processo: os serviços de todos os destinatários dividem as mesmas conexões
+// e há no máximo uma por envio simultâneo.
+class PoolConexoesSmtp {
+public:
+    static PoolConexoesSmtp& getInstance() {
+        std::lock_guard<std::mutex> lock(instanceMutex);
+        if (!instance) instance = new PoolConexoesSmtp();
+        return *instance;
+    }
+
+    CURL* adquirir(const std::string& chave) {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            auto& livres = ociosos[chave];
+            if (!livres.empty()) {
+                CURL* curl = livres.back();
+                livres.pop_back();
+                curl_easy_reset(curl);
+                return curl;
+            }
+        }
+        return curl_easy_init();
+    }
+
+    // Handle que falhou é descartado: a conexão dele pode ter ficado no meio de uma transação
+    void devolver(const std::string& chave, CURL* curl, bool reutilizavel) {
+        if (reutilizavel) {
+            std::lock_guard<std::mutex> lock(m);
+            auto& livres = ociosos[chave];
+            if (livres.size() < MAX_OCIOSOS) {
+                livres.push_back(curl);
+                return;
+            }
+        }
+        curl_easy_cleanup(curl);
+    }
+
+    // Fecha as conexões ociosas (QUIT)
+    void fechar() {
+        std::map<std::string, std::vector<CURL*>> todos;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            todos.swap(ociosos);
+        }
+        for (auto& [chave, livres] : todos) {
+            for (CURL* curl : livres) curl_easy_cleanup(curl);
+        }
+    }
+
+private:
+    static constexpr size_t MAX_OCIOSOS = 4;
+    std::mutex m;
+    std::map<std::string, std::vector<CURL*>> ociosos;
+
+    static PoolConexoesSmtp* instance;
+    static std::mutex instanceMutex;
+
+    // curl_global_init não é thread-safe: feito uma vez, antes do primeiro handle
+    PoolConexoesSmtp() { curl_global_init(CURL_GLOBAL_DEFAULT); }
+};
+
+PoolConexoesSmtp* PoolConexoesSmtp::instance = nullptr;
+std::mutex PoolConexoesSmtp::instanceMutex;
+
 // Estrutura para controlar o upload do texto
 struct UploadStatus {
     const char* data;
@@ -37,73 +116,164 @@ static size_t payload_source(char* ptr, size_t size, size_t nmemb, void* userp)
     return max_copy;
 }
 
+static std::string formatarConsumo(double consumo) {
+    std::stringstream ssConsumo;
+    ssConsumo << std::fixed << std::setprecision(2) << consumo * 1.047821;
+    return ssConsumo.str();
+}
+
+static std::string corpoAlerta(const DadosAlerta& dados) {
+    std::string consumoFormatado = formatarConsumo(dados.consumo);
+    std::string html;
+
+    // --- CORPO DO EMAIL (HTML) ---
+    html += "<html><body style='font-family: Arial, sans-serif;'>";
+    html += "<div style='border: 1px solid #ccc; padding: 20px; border-radius: 10px;'>";
+    html += "<h2 style='color: #d9534f;'>⚠️ Alerta de Consumo Crítico</h2>";
+    
+    html += "<p>O sistema detectou um consumo elevado.</p>";
+    
+    html += "<table style='width: 100%; border-collapse: collapse; margin-top: 15px;'>";
+    html += "  <tr style='background-color: #f2f2f2;'>";
+    html += "    <td style='padding: 10px; border: 1px solid #ddd;'><b>Nome do Usuário</b></td>";
+    // Mostra o Nome (Login)
+    html += "    <td style='padding: 10px; border: 1px solid #ddd;'>" + dados.nomeUser + "</td>";
+    html += "  </tr>";
+    html += "  <tr>";
+    html += "  <tr style='background-color: #f2f2f2;'>";
+    html += "    <td style='padding: 10px; border: 1px solid #ddd;'><b>Id do Usuário</b></td>";
+    html += "    <td style='padding: 10px; border: 1px solid #ddd;'>" + std::to_string(dados.userId) + "</td>";
+    html += "  </tr>";
+    html += "  <tr>";
+    html += "    <td style='padding: 10px; border: 1px solid #ddd;'><b>Consumo Medido</b></td>";
+    // Mostra o Consumo Formatado
+    html += "    <td style='padding: 10px; border: 1px solid #ddd; color: red; font-weight: bold; font-size: 18px;'>" + consumoFormatado + " m³</td>";
+    html += "  </tr>";
+    html += "  <tr style='background-color: #f2f2f2;'>";
+    html += "    <td style='padding: 10px; border: 1px solid #ddd;'><b>Data/Hora</b></td>";
+    // Formato: Dia/Mês/Ano Hora:Minuto:Segundo
+    html += "    <td style='padding: 10px; border: 1px solid #ddd;'>" + formatarDataLocal(dados.data) + "</td>";
+    html += "  </tr>";
+    html += "</table>";
+    
+    html += "<br><p style='color: #777; font-size: 12px;'>Este é um e-mail automático do Sistema de Monitoramento Hídrico (SMH).</p>";
+    html += "</div></body></html>";
+    return html;
+}
+
+// Um e-mail com todos os alertas da janela, do mais antigo para o mais recente
+static std::string corpoResumo(const std::vector<DadosAlerta>& alertas) {
+    std::string html;
+    html += "<html><body style='font-family: Arial, sans-serif;'>";
+    html += "<div style='border: 1px solid #ccc; padding: 20px; border-radius: 10px;'>";
+    html += "<h2 style='color: #d9534f;'>⚠️ " + std::to_string(alertas.size()) + " Alertas de Consumo</h2>";
+    html += "<p>Usuário <b>" + alertas.front().nomeUser + "</b> (Id " + std::to_string(alertas.front().userId) + "), entre "
+          + formatarDataLocal(alertas.front().data) + " e " + formatarDataLocal(alertas.back().data) + ".</p>";
+
+    html += "<table style='width: 100%; border-collapse: collapse; margin-top: 15px;'>";
+    html += "  <tr style='background-color: #f2f2f2;'>";
+    html += "    <td style='padding: 10px; border: 1px solid #ddd;'><b>Data/Hora</b></td>";
+    html += "    <td style='padding: 10px; border: 1px solid #ddd;'><b>Consumo Medido</b></td>";
+    html += "    <td style='padding: 10px; border: 1px solid #ddd;'><b>Regra</b></td>";
+    html += "  </tr>";
+    for (const auto& dados : alertas) {
+        html += "  <tr>";
+        html += "    <td style='padding: 10px; border: 1px solid #ddd;'>" + formatarDataLocal(dados.data) + "</td>";
+        html += "    <td style='padding: 10px; border: 1px solid #ddd; color: red; font-weight: bold;'>" + formatarConsumo(dados.consumo) + " m³</td>";
+        html += "    <td style='padding: 10px; border: 1px solid #ddd;'>" + dados.mensagem + "</td>";
+        html += "  </tr>";
+    }
+    html += "</table>";
+
+    html += "<br><p style='color: #777; font-size: 12px;'>Este é um e-mail automático do Sistema de Monitoramento Hídrico (SMH).</p>";
+    html += "</div></body></html>";
+    return html;
+}
+
+#endif
+
+bool SmtpEmailService::aceita(const DadosAlerta& dados) const {
+    return dados.userId == targetUserId;
+}
+
 void SmtpEmailService::atualizar(const DadosAlerta& dados) {
-    if (dados.userId != targetUserId) {
+    if (!aceita(dados)) {
         // std::cout << "[DEBUG] Ignorando alerta do User " << dados.userId << " (Sou User " << targetUserId << ")" << std::endl;
         return;
     }
+    if (!entregar(dados)) desistir(dados);
+}
 
+void SmtpEmailService::definirJanelaResumo(std::chrono::milliseconds janela) {
+    janelaResumoMs.store(janela.count() > 0 ? janela.count() : 0);
+}
+
+std::chrono::milliseconds SmtpEmailService::janelaResumo() const {
+    return std::chrono::milliseconds(janelaResumoMs.load());
+}
+
+bool SmtpEmailService::entregar(const DadosAlerta& dados) {
 #ifdef USE_CURL
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        std::cerr << "[EmailService] Erro ao inicializar CURL" << std::endl;
-        return;
-    }
+    if (!enviar("Alerta SMH - Consumo Alto", corpoAlerta(dados))) return false;
+    alertasEnviados++;
+    return true;
+#else
+    // Sem CURL não adianta retentar: vai direto para o arquivo
+    std::cout << "[EmailService] CURL não disponível - email não enviado" << std::endl;
+    desistir(dados);
+    return true;
+#endif
+}
 
-    std::stringstream ssConsumo;
-    ssConsumo << std::fixed << std::setprecision(2) << dados.consumo * 1.047821;
-    std::string consumoFormatado = ssConsumo.str();
+// Um e-mail só: ou o lote todo sai, ou nenhum alerta
+size_t SmtpEmailService::entregarResumo(const std::vector<DadosAlerta>& alertas) {
+    if (alertas.empty()) return 0;
+    if (alertas.size() == 1) return entregar(alertas.front()) ? 1 : 0;
+#ifdef USE_CURL
+    if (!enviar("Alerta SMH - Resumo de " + std::to_string(alertas.size()) + " alertas", corpoResumo(alertas))) return 0;
+    alertasEnviados += alertas.size();
+    resumosEnviados++;
+    return alertas.size();
+#else
+    std::cout << "[EmailService] CURL não disponível - email não enviado" << std::endl;
+    for (const auto& dados : alertas) desistir(dados);
+    return alertas.size();
+#endif
+}
 
+bool SmtpEmailService::enviar(const std::string& assunto, const std::string& corpoHtml) {
+#ifdef USE_CURL
     std::string scheme = (secure == SecureMode::SMTPS) ? "smtps://" : "smtp://";
     std::string url = scheme + smtpServer + ":" + std::to_string(port);
+    // Conexões só são divididas com quem fala com o mesmo servidor, como o mesmo usuário
+    const std::string chave = url + "|" + user;
+
+    auto& pool = PoolConexoesSmtp::getInstance();
+    CURL* curl = pool.adquirir(chave);
+    if (!curl) {
+        std::cerr << "[EmailService] Erro ao inicializar CURL" << std::endl;
+        falhasEnvio++;
+        return false;
+    }
+
     // Pega data formatada para email (RFC 2822)
     std::time_t now = std::time(nullptr);
     char dateStr[100];
     std::strftime(dateStr, sizeof(dateStr), "%a, %d %b %Y %H:%M:%S +0000", std::gmtime(&now));
+    // Vários e-mails no mesmo segundo pela mesma conexão: o contador mantém o Message-ID único
+    static std::atomic<uint64_t> sequencia{0};
 
     std::string payload = "Date: " + std::string(dateStr) + "\r\n";
     payload += "To: " + to + "\r\n";
     payload += "From: " + from + "\r\n";
-    payload += "Subject: Alerta SMH - Consumo Alto\r\n";
-    payload += "Message-ID: <" + std::to_string(now) + "@smh.local>\r\n";
+    payload += "Subject: " + assunto + "\r\n";
+    payload += "Message-ID: <" + std::to_string(now) + "." + std::to_string(sequencia++) + "@smh.local>\r\n";
 
     payload += "MIME-Version: 1.0\r\n";
     payload += "Content-Type: text/html; charset=UTF-8\r\n";
 
     payload += "\r\n"; // Linha em branco obrigatória entre header e corpo
-
-
-    // --- CORPO DO EMAIL (HTML) ---
-    payload += "<html><body style='font-family: Arial, sans-serif;'>";
-    payload += "<div style='border: 1px solid #ccc; padding: 20px; border-radius: 10px;'>";
-    payload += "<h2 style='color: #d9534f;'>⚠️ Alerta de Consumo Crítico</h2>";
-    
-    payload += "<p>O sistema detectou um consumo elevado.</p>";
-    
-    payload += "<table style='width: 100%; border-collapse: collapse; margin-top: 15px;'>";
-    payload += "  <tr style='background-color: #f2f2f2;'>";
-    payload += "    <td style='padding: 10px; border: 1px solid #ddd;'><b>Nome do Usuário</b></td>";
-    // Mostra o Nome (Login)
-    payload += "    <td style='padding: 10px; border: 1px solid #ddd;'>" + dados.nomeUser + "</td>";
-    payload += "  </tr>";
-    payload += "  <tr>";
-    payload += "  <tr style='background-color: #f2f2f2;'>";
-    payload += "    <td style='padding: 10px; border: 1px solid #ddd;'><b>Id do Usuário</b></td>";
-    payload += "    <td style='padding: 10px; border: 1px solid #ddd;'>" + std::to_string(dados.userId) + "</td>";
-    payload += "  </tr>";
-    payload += "  <tr>";
-    payload += "    <td style='padding: 10px; border: 1px solid #ddd;'><b>Consumo Medido</b></td>";
-    // Mostra o Consumo Formatado
-    payload += "    <td style='padding: 10px; border: 1px solid #ddd; color: red; font-weight: bold; font-size: 18px;'>" + consumoFormatado + " m³</td>";
-    payload += "  </tr>";
-    payload += "  <tr style='background-color: #f2f2f2;'>";
-    payload += "    <td style='padding: 10px; border: 1px solid #ddd;'><b>Data/Hora</b></td>";
-    payload += "    <td style='padding: 10px; border: 1px solid #ddd;'>" + dados.data + "</td>";
-    payload += "  </tr>";
-    payload += "</table>";
-    
-    payload += "<br><p style='color: #777; font-size: 12px;'>Este é um e-mail automático do Sistema de Monitoramento Hídrico (SMH).</p>";
-    payload += "</div></body></html>";
+    payload += corpoHtml;
     payload += "\r\n";
 
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
@@ -133,27 +303,46 @@ void SmtpEmailService::atualizar(const DadosAlerta& dados) {
 
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    // Conexão ociosa é mantida viva; se o servidor fechou, o CURL reconecta sozinho
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
     // curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
 
     CURLcode res = curl_easy_perform(curl);
+    long novas = 0;
+    if (curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &novas) == CURLE_OK && novas > 0) conexoesAbertas += novas;
+    // A lista não pode sobreviver no handle que volta para o pool
+    curl_easy_setopt(curl, CURLOPT_MAIL_RCPT, (struct curl_slist*)nullptr);
     if (recipients) curl_slist_free_all(recipients);
+    pool.devolver(chave, curl, res == CURLE_OK);
+
     if (res != CURLE_OK) {
+        // Quem chamou decide: retentar (despachante) ou cair no arquivo (desistir)
         std::cerr << "[EmailService] Erro ao enviar email: " << curl_easy_strerror(res) << std::endl;
-        // Fallback: salva em disco
-        curl_easy_cleanup(curl);
-        goto fallback_file;
-    } else {
-        std::cout << "[EmailService] Email enviado com sucesso!" << std::endl;
+        falhasEnvio++;
+        return false;
     }
-
-    curl_easy_cleanup(curl);
+    emailsEnviados++;
+    std::cout << "[EmailService] Email enviado com sucesso!" << std::endl;
+    return true;
 #else
-    std::cout << "[EmailService] CURL não disponível - email não enviado" << std::endl;
-    goto fallback_file;
+    (void)assunto;
+    (void)corpoHtml;
+    return false;
+#endif
+}
+
+void SmtpEmailService::encerrarConexoes() {
+#ifdef USE_CURL
+    PoolConexoesSmtp::getInstance().fechar();
 #endif
-    return;
+}
+
+SmtpEmailService::Estatisticas SmtpEmailService::estatisticas() {
+    return {emailsEnviados.load(), alertasEnviados.load(), resumosEnviados.load(), conexoesAbertas.load(), falhasEnvio.load()};
+}
 
-fallback_file:
+// Fallback: salva em disco
+void SmtpEmailService::desistir(const DadosAlerta& dados) {
     try {
         namespace fs = std::filesystem;
         fs::create_directories("./data/email_outbox");
@@ -166,7 +355,7 @@ fallback_file:
             out << "Subject: Alerta SMH\r\n\r\n";
             out << "ALERTA: Consumo de " << dados.consumo << " detectado.\n";
             out << "Mensagem: " << dados.mensagem << "\n";
-            out << "Data: " << dados.data << "\n";
+            out << "Data: " << formatarDataLocal(dados.data) << "\n";
             out.close();
             std::cout << "[EmailService] (fallback) Email salvo em arquivo: " << fn.str() << std::endl;
         } else {
@@ -3,17 +3,48 @@
 
 #include "core.h"
 #include <string>
+#include <vector>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 
-class SmtpEmailService : public IEventoObserver {
+// Como IEventoObserver envia na hora (e salva em ./data/email_outbox se falhar);
+// como ICanalEntrega deixa o despachante de notificações retentar antes disso.
+// As conexões com o servidor ficam abertas num pool do processo e são
+// reaproveitadas entre envios, de todos os destinatários.
+class SmtpEmailService : public IEventoObserver, public ICanalEntrega {
 public:
     enum class SecureMode { NONE, STARTTLS, SMTPS };
 
+    // Contadores do processo (todos os serviços)
+    struct Estatisticas {
+        uint64_t emails = 0;
+        uint64_t alertas = 0;        // alertas contidos nos e-mails (resumo conta todos)
+        uint64_t resumos = 0;
+        uint64_t conexoesNovas = 0;  // conexões abertas; emails - conexoesNovas = reaproveitadas
+        uint64_t falhas = 0;
+    };
+
     SmtpEmailService(const std::string& server, int p, const std::string& fromAddr,
                      const std::string& toAddr, const std::string& u, const std::string& pass, SecureMode mode, int targetUid);
 
     void atualizar(const DadosAlerta& dados) override;
 
+    bool aceita(const DadosAlerta& dados) const override;
+    bool entregar(const DadosAlerta& dados) override;
+    void desistir(const DadosAlerta& dados) override;
+
+    // Modo resumo: alertas do mesmo destinatário dentro da janela viram um
+    // e-mail só (0 = um e-mail por alerta). Vale na entrega pelo despachante.
+    void definirJanelaResumo(std::chrono::milliseconds janela);
+    std::chrono::milliseconds janelaResumo() const override;
+    size_t entregarResumo(const std::vector<DadosAlerta>& alertas) override;
+
+    // Fecha as conexões ociosas do pool (ao encerrar o programa)
+    static void encerrarConexoes();
+    static Estatisticas estatisticas();
+
 private:
     std::string smtpServer;
     int port;
@@ -23,6 +54,9 @@ private:
     std::string password;
     int targetUserId; // ID do usuario dono deste email
     SecureMode secure;
+    std::atomic<int64_t> janelaResumoMs{0};
+
+    bool enviar(const std::string& assunto, const std::string& corpoHtml);
 };
 
 #endif // SMTP_EMAIL_H
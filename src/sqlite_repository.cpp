@@ -2,24 +2,114 @@
 #include <iostream>
 #include <stdexcept>
 #include <sstream>
+#include <algorithm>
 
-// ==================== UsuarioRepositorySQLite ====================
+// ==================== StatementCache ====================
+
+sqlite3_stmt* StatementCache::obter(const std::string& sql) {
+    auto it = stmts.find(sql);
+    if (it == stmts.end()) {
+        sqlite3_stmt* stmt = nullptr;
+        prepares.fetch_add(1, std::memory_order_relaxed);
+        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            return nullptr;
+        }
+        it = stmts.emplace(sql, stmt).first;
+    }
+    execucoes.fetch_add(1, std::memory_order_relaxed);
+    return it->second;
+}
 
-UsuarioRepositorySQLite::UsuarioRepositorySQLite(const std::string& path) : dbPath(path) {
-    int ret = sqlite3_open(path.c_str(), &db);
-    if (ret != SQLITE_OK) {
+void StatementCache::finalizarTodos() {
+    for (auto& [sql, stmt] : stmts) sqlite3_finalize(stmt);
+    stmts.clear();
+}
+
+// ==================== CONEXÕES ====================
+
+// Tempo que uma conexão espera por um lock de outra antes de devolver SQLITE_BUSY
+static const int BUSY_TIMEOUT_MS = 5000;
+
+static sqlite3* abrirConexao(const std::string& path, bool somenteLeitura) {
+    sqlite3* db = nullptr;
+    int flags = somenteLeitura ? SQLITE_OPEN_READONLY : (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+    // Cada conexão é usada por uma thread de cada vez (dbMutex ou pool), então dispensamos o mutex interno
+    flags |= SQLITE_OPEN_NOMUTEX;
+    if (sqlite3_open_v2(path.c_str(), &db, flags, nullptr) != SQLITE_OK) {
+        if (db) sqlite3_close(db);
         throw std::runtime_error("Não foi possível abrir banco: " + path);
     }
-    initSchema();
+    sqlite3_busy_timeout(db, BUSY_TIMEOUT_MS);
+    if (!somenteLeitura) {
+        // WAL: leitores não bloqueiam o writer e vice-versa
+        sqlite3_exec(db, "PRAGMA journal_mode=WAL", nullptr, nullptr, nullptr);
+    }
+    return db;
 }
 
-UsuarioRepositorySQLite::~UsuarioRepositorySQLite() {
-    if (db) sqlite3_close(db);
+// ==================== PoolLeitura ====================
+
+void PoolLeitura::abrir(const std::string& path, size_t tamanho) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    for (size_t i = 0; i < std::max<size_t>(tamanho, 1); i++) {
+        auto c = std::make_unique<Conexao>();
+        c->db = abrirConexao(path, true);
+        c->stmts.setConexao(c->db);
+        livres.push_back(c.get());
+        conexoes.push_back(std::move(c));
+    }
 }
 
-void UsuarioRepositorySQLite::initSchema() {
-    std::lock_guard<std::mutex> lock(dbMutex);
-    const char* schema = R"(
+void PoolLeitura::fechar() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    for (auto& c : conexoes) {
+        c->stmts.finalizarTodos();
+        sqlite3_close(c->db);
+    }
+    conexoes.clear();
+    livres.clear();
+}
+
+PoolLeitura::Handle PoolLeitura::adquirir() {
+    std::unique_lock<std::mutex> lock(poolMutex);
+    livreCv.wait(lock, [&] { return !livres.empty(); });
+    Conexao* c = livres.back();
+    livres.pop_back();
+    return Handle(this, c);
+}
+
+void PoolLeitura::devolver(Conexao* c) {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        livres.push_back(c);
+    }
+    livreCv.notify_one();
+}
+
+StatementCache::Estatisticas PoolLeitura::estatisticas() const {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    StatementCache::Estatisticas total;
+    for (const auto& c : conexoes) {
+        auto e = c->stmts.estatisticas();
+        total.prepares += e.prepares;
+        total.execucoes += e.execucoes;
+    }
+    return total;
+}
+
+// ==================== MIGRAÇÕES ====================
+
+// Cada migração leva o banco da versão (versao - 1) para `versao`.
+// A versão corrente fica em PRAGMA user_version; bancos antigos (versão 0)
+// são atualizados no lugar ao abrir.
+struct Migracao {
+    int versao;
+    const char* sql;
+};
+
+static const Migracao MIGRACOES[] = {
+    // 1: schema original (IF NOT EXISTS: bancos criados antes das migrações já o têm)
+    {1, R"(
         CREATE TABLE IF NOT EXISTS TB_USUARIO (
             id INTEGER PRIMARY KEY AUTOINCREMENT,
             login TEXT UNIQUE NOT NULL,
@@ -59,49 +149,162 @@ void UsuarioRepositorySQLite::initSchema() {
             extra INTEGER,
             FOREIGN KEY(user_id) REFERENCES TB_USUARIO(id)
         );
-    )";
-
+    )"},
+    // 2: índices dos caminhos quentes (histórico por usuário e vínculos)
+    {2, R"(
+        CREATE INDEX IF NOT EXISTS IDX_LEITURAS_USER_ID ON TB_LEITURAS(user_id, id);
+        CREATE INDEX IF NOT EXISTS IDX_LEITURAS_USER_SHA ON TB_LEITURAS(user_id, idSHA);
+        CREATE INDEX IF NOT EXISTS IDX_ALERTAS_USER_ID ON TB_ALERTAS(user_id, id);
+        CREATE INDEX IF NOT EXISTS IDX_REGRAS_USER ON TB_REGRAS(user_id);
+        CREATE INDEX IF NOT EXISTS IDX_VINCULO_USER_SHA ON TB_VINCULO(user_id, idSHA);
+        CREATE INDEX IF NOT EXISTS IDX_VINCULO_SHA ON TB_VINCULO(idSHA);
+    )"},
+    // 3: coluna `data` passa de texto (ISO / dd/mm/yyyy local) para INTEGER em ms desde a epoch.
+    // SQLite não altera o tipo de coluna, então as tabelas são recriadas e os índices refeitos.
+    {3, R"(
+        CREATE TABLE TB_LEITURAS_V3 (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            user_id INTEGER NOT NULL,
+            idSHA TEXT NOT NULL,
+            data INTEGER NOT NULL,
+            valor REAL NOT NULL,
+            caminhoImagem TEXT,
+            FOREIGN KEY(user_id) REFERENCES TB_USUARIO(id)
+        );
+        INSERT INTO TB_LEITURAS_V3 (id, user_id, idSHA, data, valor, caminhoImagem)
+            SELECT id, user_id, idSHA,
+                   COALESCE(CAST(strftime('%s', data) AS INTEGER) * 1000, 0),
+                   valor, caminhoImagem
+            FROM TB_LEITURAS;
+        DROP TABLE TB_LEITURAS;
+        ALTER TABLE TB_LEITURAS_V3 RENAME TO TB_LEITURAS;
+
+        CREATE TABLE TB_ALERTAS_V3 (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            user_id INTEGER NOT NULL,
+            consumo REAL NOT NULL,
+            mensagem TEXT NOT NULL,
+            data INTEGER NOT NULL,
+            FOREIGN KEY(user_id) REFERENCES TB_USUARIO(id)
+        );
+        INSERT INTO TB_ALERTAS_V3 (id, user_id, consumo, mensagem, data)
+            SELECT id, user_id, consumo, mensagem,
+                   COALESCE(CAST(strftime('%s',
+                       substr(data, 7, 4) || '-' || substr(data, 4, 2) || '-' || substr(data, 1, 2) || ' ' || substr(data, 12, 8),
+                       'utc') AS INTEGER) * 1000, 0)
+            FROM TB_ALERTAS;
+        DROP TABLE TB_ALERTAS;
+        ALTER TABLE TB_ALERTAS_V3 RENAME TO TB_ALERTAS;
+
+        CREATE INDEX IF NOT EXISTS IDX_LEITURAS_USER_ID ON TB_LEITURAS(user_id, id);
+        CREATE INDEX IF NOT EXISTS IDX_LEITURAS_USER_SHA ON TB_LEITURAS(user_id, idSHA);
+        CREATE INDEX IF NOT EXISTS IDX_LEITURAS_USER_DATA ON TB_LEITURAS(user_id, data);
+        CREATE INDEX IF NOT EXISTS IDX_ALERTAS_USER_ID ON TB_ALERTAS(user_id, id);
+        CREATE INDEX IF NOT EXISTS IDX_ALERTAS_USER_DATA ON TB_ALERTAS(user_id, data);
+    )"},
+    // 4: keyset (data, id) da consulta paginada: os índices por data passam a
+    // incluir o id, e o filtro por idSHA ganha a data para não ordenar em memória
+    {4, R"(
+        DROP INDEX IF EXISTS IDX_LEITURAS_USER_DATA;
+        DROP INDEX IF EXISTS IDX_LEITURAS_USER_SHA;
+        DROP INDEX IF EXISTS IDX_ALERTAS_USER_DATA;
+        CREATE INDEX IF NOT EXISTS IDX_LEITURAS_USER_DATA_ID ON TB_LEITURAS(user_id, data, id);
+        CREATE INDEX IF NOT EXISTS IDX_LEITURAS_USER_SHA_DATA ON TB_LEITURAS(user_id, idSHA, data, id);
+        CREATE INDEX IF NOT EXISTS IDX_ALERTAS_USER_DATA_ID ON TB_ALERTAS(user_id, data, id);
+    )"},
+};
+
+static void execOuFalha(sqlite3* db, const std::string& sql, const std::string& contexto) {
     char* errMsg = nullptr;
-    if (sqlite3_exec(db, schema, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
         std::string error = errMsg ? errMsg : "unknown error";
         sqlite3_free(errMsg);
-        throw std::runtime_error("Erro ao criar schema: " + error);
+        throw std::runtime_error(contexto + ": " + error);
     }
 }
 
-std::optional<Usuario> UsuarioRepositorySQLite::carregarUsuarioComHidrometros(int id) {
-    std::string query = "SELECT id, login, senhaHash, perfil, email FROM TB_USUARIO WHERE id = ?";
-
+static int lerVersaoSchema(sqlite3* db) {
     sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return std::nullopt;
+    int versao = 0;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) versao = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
     }
+    return versao;
+}
 
-    sqlite3_bind_int(stmt, 1, id);
-    if (sqlite3_step(stmt) != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
+void aplicarMigracoes(sqlite3* db) {
+    for (const auto& m : MIGRACOES) {
+        // BEGIN IMMEDIATE serializa conexões que abrem o mesmo arquivo ao mesmo tempo;
+        // a versão é relida dentro da transação.
+        execOuFalha(db, "BEGIN IMMEDIATE", "Erro ao iniciar migração");
+        if (lerVersaoSchema(db) >= m.versao) {
+            sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+            continue;
+        }
+        try {
+            execOuFalha(db, m.sql, "Erro na migração " + std::to_string(m.versao));
+            execOuFalha(db, "PRAGMA user_version = " + std::to_string(m.versao), "Erro ao gravar versão do schema");
+            execOuFalha(db, "COMMIT", "Erro ao efetivar migração " + std::to_string(m.versao));
+        } catch (...) {
+            sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+            throw;
+        }
+    }
+}
+
+// ==================== UsuarioRepositorySQLite ====================
+
+UsuarioRepositorySQLite::UsuarioRepositorySQLite(const std::string& path, size_t conexoesLeitura) : dbPath(path) {
+    db = abrirConexao(path, false);
+    stmts.setConexao(db);
+    initSchema();
+    // Leitores só depois do schema existir (conexões READONLY não criam o arquivo)
+    leitores.abrir(path, conexoesLeitura);
+}
+
+UsuarioRepositorySQLite::~UsuarioRepositorySQLite() {
+    leitores.fechar();
+    stmts.finalizarTodos();
+    if (db) sqlite3_close(db);
+}
+
+void UsuarioRepositorySQLite::initSchema() {
+    std::lock_guard<std::mutex> lock(dbMutex);
+    aplicarMigracoes(db);
+}
+
+std::optional<Usuario> UsuarioRepositorySQLite::carregarUsuarioComHidrometros(StatementCache& cache, int id) {
+    sqlite3_stmt* stmt = cache.obter("SELECT id, login, senhaHash, perfil, email FROM TB_USUARIO WHERE id = ?");
+    if (!stmt) {
         return std::nullopt;
     }
 
     Usuario user;
-    user.id = sqlite3_column_int(stmt, 0);
-    user.login = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-    user.senhaHash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-    user.perfil = static_cast<Perfil>(sqlite3_column_int(stmt, 3));
+    {
+        StmtReset reset(stmt);
+        sqlite3_bind_int(stmt, 1, id);
+        if (sqlite3_step(stmt) != SQLITE_ROW) {
+            return std::nullopt;
+        }
 
-    const char* emailText = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-    user.email = emailText ? emailText : "";
+        user.id = sqlite3_column_int(stmt, 0);
+        user.login = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        user.senhaHash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        user.perfil = static_cast<Perfil>(sqlite3_column_int(stmt, 3));
 
-    sqlite3_finalize(stmt);
+        const char* emailText = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+        user.email = emailText ? emailText : "";
+    }
 
     // Carregar hidrometros
-    query = "SELECT idSHA FROM TB_VINCULO WHERE user_id = ?";
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    stmt = cache.obter("SELECT idSHA FROM TB_VINCULO WHERE user_id = ?");
+    if (stmt) {
+        StmtReset reset(stmt);
         sqlite3_bind_int(stmt, 1, id);
         while (sqlite3_step(stmt) == SQLITE_ROW) {
             user.hidrometros.push_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
         }
-        sqlite3_finalize(stmt);
     }
 
     return user;
@@ -113,233 +316,390 @@ Usuario UsuarioRepositorySQLite::salvar(const Usuario& user) {
 
     if (user.id == 0) {
         // INSERT
-        std::string query = "INSERT INTO TB_USUARIO (login, senhaHash, perfil, email) VALUES (?, ?, ?, ?)";
-        sqlite3_stmt* stmt = nullptr;
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_stmt* stmt = stmts.obter("INSERT INTO TB_USUARIO (login, senhaHash, perfil, email) VALUES (?, ?, ?, ?)");
+        if (!stmt) {
             throw std::runtime_error("Erro ao preparar INSERT usuario");
         }
+        StmtReset reset(stmt);
         sqlite3_bind_text(stmt, 1, user.login.c_str(), -1, SQLITE_STATIC);
         sqlite3_bind_text(stmt, 2, user.senhaHash.c_str(), -1, SQLITE_STATIC);
         sqlite3_bind_int(stmt, 3, static_cast<int>(user.perfil));
         sqlite3_bind_text(stmt, 4, user.email.c_str(), -1, SQLITE_STATIC);
 
         if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
             throw std::runtime_error("Erro ao inserir usuario");
         }
-        sqlite3_finalize(stmt);
         result.id = static_cast<int>(sqlite3_last_insert_rowid(db));
     } else {
         // UPDATE
-        std::string query = "UPDATE TB_USUARIO SET senhaHash = ?, perfil = ?, email = ? WHERE id = ?";
-
-        sqlite3_stmt* stmt = nullptr;
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_stmt* stmt = stmts.obter("UPDATE TB_USUARIO SET senhaHash = ?, perfil = ?, email = ? WHERE id = ?");
+        if (!stmt) {
             throw std::runtime_error("Erro ao preparar UPDATE usuario");
         }
+        StmtReset reset(stmt);
         sqlite3_bind_text(stmt, 1, user.senhaHash.c_str(), -1, SQLITE_STATIC);
         sqlite3_bind_int(stmt, 2, static_cast<int>(user.perfil));
-        sqlite3_bind_int(stmt, 3, user.id);
         sqlite3_bind_text(stmt, 3, user.email.c_str(), -1, SQLITE_STATIC);
-        
+        sqlite3_bind_int(stmt, 4, user.id);
+
         if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
             throw std::runtime_error("Erro ao atualizar usuario");
         }
-        sqlite3_finalize(stmt);
     }
 
     return result;
 }
 
 std::optional<Usuario> UsuarioRepositorySQLite::buscarPorLogin(const std::string& login) {
-    std::lock_guard<std::mutex> lock(dbMutex);
-    std::string query = "SELECT id FROM TB_USUARIO WHERE login = ?";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    auto conexao = leitores.adquirir();
+    sqlite3_stmt* stmt = conexao.stmts().obter("SELECT id FROM TB_USUARIO WHERE login = ?");
+    if (!stmt) {
         return std::nullopt;
     }
-    sqlite3_bind_text(stmt, 1, login.c_str(), -1, SQLITE_STATIC);
-    if (sqlite3_step(stmt) != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
-        return std::nullopt;
+    int id = 0;
+    {
+        StmtReset reset(stmt);
+        sqlite3_bind_text(stmt, 1, login.c_str(), -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) != SQLITE_ROW) {
+            return std::nullopt;
+        }
+        id = sqlite3_column_int(stmt, 0);
     }
-    int id = sqlite3_column_int(stmt, 0);
-    sqlite3_finalize(stmt);
 
-    return carregarUsuarioComHidrometros(id);
+    return carregarUsuarioComHidrometros(conexao.stmts(), id);
 }
 
 std::optional<Usuario> UsuarioRepositorySQLite::buscarPorId(int id) {
-    std::lock_guard<std::mutex> lock(dbMutex);
-    return carregarUsuarioComHidrometros(id);
+    auto conexao = leitores.adquirir();
+    return carregarUsuarioComHidrometros(conexao.stmts(), id);
 }
 
 void UsuarioRepositorySQLite::deletar(int id) {
     std::lock_guard<std::mutex> lock(dbMutex);
-    std::string query = "DELETE FROM TB_USUARIO WHERE id = ?";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    sqlite3_stmt* stmt = stmts.obter("DELETE FROM TB_USUARIO WHERE id = ?");
+    if (stmt) {
+        StmtReset reset(stmt);
         sqlite3_bind_int(stmt, 1, id);
         sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
     }
 }
 
 void UsuarioRepositorySQLite::vincularHidrometro(int userId, const std::string& idSHA) {
     std::lock_guard<std::mutex> lock(dbMutex);
-    std::string query = "INSERT INTO TB_VINCULO (user_id, idSHA) VALUES (?, ?)";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    sqlite3_stmt* stmt = stmts.obter("INSERT INTO TB_VINCULO (user_id, idSHA) VALUES (?, ?)");
+    if (!stmt) {
         throw std::runtime_error("Erro ao preparar vinculo");
     }
+    StmtReset reset(stmt);
     sqlite3_bind_int(stmt, 1, userId);
     sqlite3_bind_text(stmt, 2, idSHA.c_str(), -1, SQLITE_STATIC);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
         throw std::runtime_error("Erro ao vincular hidrometro");
     }
-    sqlite3_finalize(stmt);
 }
 
 void UsuarioRepositorySQLite::desvincularHidrometro(int userId, const std::string& idSHA) {
     std::lock_guard<std::mutex> lock(dbMutex);
-    std::string query = "DELETE FROM TB_VINCULO WHERE user_id = ? AND idSHA = ?";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    sqlite3_stmt* stmt = stmts.obter("DELETE FROM TB_VINCULO WHERE user_id = ? AND idSHA = ?");
+    if (!stmt) {
         throw std::runtime_error("Erro ao preparar desvincular");
     }
+    StmtReset reset(stmt);
     sqlite3_bind_int(stmt, 1, userId);
     sqlite3_bind_text(stmt, 2, idSHA.c_str(), -1, SQLITE_STATIC);
 
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
 }
 
 std::vector<Usuario> UsuarioRepositorySQLite::listarTodosUsuarios() {
-    std::lock_guard<std::mutex> lock(dbMutex);
+    auto conexao = leitores.adquirir();
     std::vector<Usuario> usuarios;
-    std::string query = "SELECT id FROM TB_USUARIO";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    // Uma única consulta: usuários e vínculos chegam ordenados por usuário,
+    // então basta agrupar linhas consecutivas com o mesmo id.
+    sqlite3_stmt* stmt = conexao.stmts().obter(
+        "SELECT u.id, u.login, u.senhaHash, u.perfil, u.email, v.idSHA "
+        "FROM TB_USUARIO u LEFT JOIN TB_VINCULO v ON v.user_id = u.id "
+        "ORDER BY u.id, v.id");
+    if (stmt) {
+        StmtReset reset(stmt);
         while (sqlite3_step(stmt) == SQLITE_ROW) {
             int id = sqlite3_column_int(stmt, 0);
-            if (auto user = carregarUsuarioComHidrometros(id)) {
-                usuarios.push_back(*user);
+            if (usuarios.empty() || usuarios.back().id != id) {
+                Usuario user;
+                user.id = id;
+                user.login = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+                user.senhaHash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+                user.perfil = static_cast<Perfil>(sqlite3_column_int(stmt, 3));
+                const char* emailText = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+                user.email = emailText ? emailText : "";
+                usuarios.push_back(std::move(user));
             }
+            // LEFT JOIN: usuário sem vínculo vem com idSHA NULL
+            const char* sha = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
+            if (sha) usuarios.back().hidrometros.push_back(sha);
         }
-        sqlite3_finalize(stmt);
     }
     return usuarios;
 }
 
+StatementCache::Estatisticas UsuarioRepositorySQLite::estatisticasStatements() const {
+    auto total = leitores.estatisticas();
+    auto escrita = stmts.estatisticas();
+    total.prepares += escrita.prepares;
+    total.execucoes += escrita.execucoes;
+    return total;
+}
+
 // ==================== HistoricoRepositorySQLite ====================
 
-HistoricoRepositorySQLite::HistoricoRepositorySQLite(const std::string& path) : dbPath(path) {
-    int ret = sqlite3_open(path.c_str(), &db);
-    if (ret != SQLITE_OK) {
-        throw std::runtime_error("Não foi possível abrir banco: " + path);
-    }
+static std::string colunaTexto(sqlite3_stmt* stmt, int col) {
+    const char* txt = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+    return txt ? txt : "";
+}
+
+// Colunas esperadas: id, user_id, idSHA, data, valor, caminhoImagem
+static Leitura lerLeitura(sqlite3_stmt* stmt) {
+    Leitura leitura;
+    leitura.id = sqlite3_column_int(stmt, 0);
+    leitura.userId = sqlite3_column_int(stmt, 1);
+    leitura.idSHA = colunaTexto(stmt, 2);
+    leitura.data = sqlite3_column_int64(stmt, 3);
+    leitura.valor = sqlite3_column_double(stmt, 4);
+    leitura.caminhoImagem = colunaTexto(stmt, 5);
+    return leitura;
+}
+
+// Colunas esperadas: id, user_id, consumo, mensagem, data
+static AlertaRecord lerAlerta(sqlite3_stmt* stmt) {
+    AlertaRecord alerta;
+    alerta.id = sqlite3_column_int(stmt, 0);
+    alerta.userId = sqlite3_column_int(stmt, 1);
+    alerta.consumo = sqlite3_column_double(stmt, 2);
+    alerta.mensagem = colunaTexto(stmt, 3);
+    alerta.data = sqlite3_column_int64(stmt, 4);
+    return alerta;
+}
+
+HistoricoRepositorySQLite::HistoricoRepositorySQLite(const std::string& path, size_t conexoesLeitura) : dbPath(path) {
+    db = abrirConexao(path, false);
+    stmts.setConexao(db);
     initSchema();
+    leitores.abrir(path, conexoesLeitura);
 }
 
 HistoricoRepositorySQLite::~HistoricoRepositorySQLite() {
+    if (writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(filaMutex);
+            encerrando = true;
+        }
+        filaCv.notify_all();
+        writer.join();
+    }
+    leitores.fechar();
+    stmts.finalizarTodos();
     if (db) sqlite3_close(db);
 }
 
 void HistoricoRepositorySQLite::initSchema() {
     std::lock_guard<std::mutex> lock(dbMutex);
-    // Schema já foi criado por UsuarioRepositorySQLite
+    // Normalmente UsuarioRepositorySQLite já migrou o banco; aqui vira no-op
+    aplicarMigracoes(db);
+}
+
+void HistoricoRepositorySQLite::ativarEscritaAssincrona(const ConfigEscritaAssincrona& cfg) {
+    std::lock_guard<std::mutex> lockFila(filaMutex);
+    if (assincrono) return;
+    {
+        std::lock_guard<std::mutex> lock(dbMutex);
+        // Em WAL, synchronous=NORMAL só faz fsync no checkpoint, não a cada commit
+        sqlite3_exec(db, "PRAGMA synchronous=NORMAL", nullptr, nullptr, nullptr);
+    }
+    cfgEscrita = cfg;
+    if (cfgEscrita.capacidadeFila == 0) cfgEscrita.capacidadeFila = 1;
+    if (cfgEscrita.tamanhoLote == 0) cfgEscrita.tamanhoLote = 1;
+    assincrono = true;
+    writer = std::thread(&HistoricoRepositorySQLite::loopWriter, this);
+}
+
+void HistoricoRepositorySQLite::flush() {
+    std::unique_lock<std::mutex> lock(filaMutex);
+    if (!assincrono) return;
+    uint64_t alvo = enfileiradas;
+    flushSolicitado = true;
+    filaCv.notify_one();
+    espacoCv.wait(lock, [&] { return processadas >= alvo; });
+}
+
+EstatisticasEscrita HistoricoRepositorySQLite::estatisticasEscrita() const {
+    std::lock_guard<std::mutex> lock(filaMutex);
+    EstatisticasEscrita est;
+    est.pendentes = filaLeituras.size();
+    est.gravadas = gravadas;
+    est.falhas = falhas;
+    est.lotes = lotes;
+    if (!filaLeituras.empty()) {
+        est.atrasoMaisAntigoMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - filaLeituras.front().enfileiradaEm).count();
+    }
+    return est;
+}
+
+void HistoricoRepositorySQLite::loopWriter() {
+    std::vector<LeituraPendente> lote;
+    std::unique_lock<std::mutex> lock(filaMutex);
+    while (true) {
+        // Espera lote cheio, flush explícito, encerramento ou estouro do intervalo
+        filaCv.wait_for(lock, cfgEscrita.intervaloFlush, [&] {
+            return encerrando || flushSolicitado || filaLeituras.size() >= cfgEscrita.tamanhoLote;
+        });
+        if (filaLeituras.empty()) {
+            flushSolicitado = false;
+            if (encerrando) break;
+            continue;
+        }
+
+        size_t n = std::min(filaLeituras.size(), cfgEscrita.tamanhoLote);
+        lote.clear();
+        for (size_t i = 0; i < n; i++) {
+            lote.push_back(std::move(filaLeituras.front()));
+            filaLeituras.pop_front();
+        }
+        if (filaLeituras.empty()) flushSolicitado = false;
+        espacoCv.notify_all();
+
+        lock.unlock();
+        size_t perdidas = gravarLote(lote);
+        lock.lock();
+
+        processadas += lote.size();
+        gravadas += lote.size() - perdidas;
+        falhas += perdidas;
+        lotes++;
+        espacoCv.notify_all();
+    }
+}
+
+size_t HistoricoRepositorySQLite::gravarLote(std::vector<LeituraPendente>& lote) {
+    std::lock_guard<std::mutex> lock(dbMutex);
+    if (sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr) == SQLITE_OK) {
+        try {
+            for (const auto& p : lote) inserirLeitura(p.leitura);
+            if (sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr) == SQLITE_OK) return 0;
+            throw std::runtime_error(std::string("COMMIT falhou: ") + sqlite3_errmsg(db));
+        } catch (const std::exception& e) {
+            sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+            std::cerr << "[HistoricoRepositorySQLite] Lote de " << lote.size()
+                      << " leituras desfeito (" << e.what() << "); gravando uma a uma" << std::endl;
+        }
+    } else {
+        std::cerr << "[HistoricoRepositorySQLite] BEGIN falhou: " << sqlite3_errmsg(db)
+                  << "; gravando o lote uma a uma" << std::endl;
+    }
+
+    // Sem transação: cada leitura vira seu próprio commit e só a defeituosa se perde
+    size_t perdidas = 0;
+    for (const auto& p : lote) {
+        try {
+            inserirLeitura(p.leitura);
+        } catch (const std::exception& e) {
+            perdidas++;
+            std::cerr << "[HistoricoRepositorySQLite] Leitura de " << p.leitura.idSHA
+                      << " descartada: " << e.what() << std::endl;
+        }
+    }
+    return perdidas;
 }
 
 void HistoricoRepositorySQLite::salvarLeitura(const Leitura& leitura) {
+    {
+        std::unique_lock<std::mutex> lock(filaMutex);
+        if (assincrono) {
+            espacoCv.wait(lock, [&] { return filaLeituras.size() < cfgEscrita.capacidadeFila; });
+            filaLeituras.push_back({leitura, std::chrono::steady_clock::now()});
+            enfileiradas++;
+            if (filaLeituras.size() >= cfgEscrita.tamanhoLote) filaCv.notify_one();
+            return;
+        }
+    }
     std::lock_guard<std::mutex> lock(dbMutex);
-    std::string query = "INSERT INTO TB_LEITURAS (user_id, idSHA, data, valor, caminhoImagem) VALUES (?, ?, ?, ?, ?)";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    inserirLeitura(leitura);
+}
+
+void HistoricoRepositorySQLite::inserirLeitura(const Leitura& leitura) {
+    sqlite3_stmt* stmt = stmts.obter("INSERT INTO TB_LEITURAS (user_id, idSHA, data, valor, caminhoImagem) VALUES (?, ?, ?, ?, ?)");
+    if (!stmt) {
         throw std::runtime_error("Erro ao preparar salvar leitura");
     }
+    StmtReset reset(stmt);
     sqlite3_bind_int(stmt, 1, leitura.userId);
     sqlite3_bind_text(stmt, 2, leitura.idSHA.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 3, leitura.data.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 3, leitura.data);
     sqlite3_bind_double(stmt, 4, leitura.valor);
     sqlite3_bind_text(stmt, 5, leitura.caminhoImagem.c_str(), -1, SQLITE_STATIC);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
         throw std::runtime_error("Erro ao inserir leitura");
     }
-    sqlite3_finalize(stmt);
 }
 
 void HistoricoRepositorySQLite::salvarAlerta(const AlertaRecord& alerta) {
     std::lock_guard<std::mutex> lock(dbMutex);
-    std::string query = "INSERT INTO TB_ALERTAS (user_id, consumo, mensagem, data) VALUES (?, ?, ?, ?)";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    sqlite3_stmt* stmt = stmts.obter("INSERT INTO TB_ALERTAS (user_id, consumo, mensagem, data) VALUES (?, ?, ?, ?)");
+    if (!stmt) {
         throw std::runtime_error("Erro ao preparar salvar alerta");
     }
+    StmtReset reset(stmt);
     sqlite3_bind_int(stmt, 1, alerta.userId);
     sqlite3_bind_double(stmt, 2, alerta.consumo);
     sqlite3_bind_text(stmt, 3, alerta.mensagem.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 4, alerta.data.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 4, alerta.data);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
         throw std::runtime_error("Erro ao inserir alerta");
     }
-    sqlite3_finalize(stmt);
 }
 
 std::vector<AlertaRecord> HistoricoRepositorySQLite::listarAlertasPorUsuario(int userId) {
-    std::lock_guard<std::mutex> lock(dbMutex);
+    auto conexao = leitores.adquirir();
     std::vector<AlertaRecord> alertas;
-    std::string query = "SELECT id, user_id, consumo, mensagem, data FROM TB_ALERTAS WHERE user_id = ? ORDER BY id DESC";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    sqlite3_stmt* stmt = conexao.stmts().obter("SELECT id, user_id, consumo, mensagem, data FROM TB_ALERTAS WHERE user_id = ? ORDER BY id DESC");
+    if (stmt) {
+        StmtReset reset(stmt);
         sqlite3_bind_int(stmt, 1, userId);
         while (sqlite3_step(stmt) == SQLITE_ROW) {
-            AlertaRecord alerta;
-            alerta.id = sqlite3_column_int(stmt, 0);
-            alerta.userId = sqlite3_column_int(stmt, 1);
-            alerta.consumo = sqlite3_column_double(stmt, 2);
-            alerta.mensagem = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-            alerta.data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-            alertas.push_back(alerta);
+            alertas.push_back(lerAlerta(stmt));
         }
-        sqlite3_finalize(stmt);
     }
     return alertas;
 }
 
 int HistoricoRepositorySQLite::salvarRegra(int userId, const std::string& tipo, double valor, int extra) {
     std::lock_guard<std::mutex> lock(dbMutex);
-    std::string query = "INSERT INTO TB_REGRAS (user_id, tipo, valor, extra) VALUES (?, ?, ?, ?)";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    sqlite3_stmt* stmt = stmts.obter("INSERT INTO TB_REGRAS (user_id, tipo, valor, extra) VALUES (?, ?, ?, ?)");
+    if (!stmt) {
         throw std::runtime_error("Erro ao preparar salvar regra");
     }
+    StmtReset reset(stmt);
     sqlite3_bind_int(stmt, 1, userId);
     sqlite3_bind_text(stmt, 2, tipo.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_double(stmt, 3, valor);
     sqlite3_bind_int(stmt, 4, extra);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
         throw std::runtime_error("Erro ao inserir regra");
     }
-    sqlite3_finalize(stmt);
     int ruleId = static_cast<int>(sqlite3_last_insert_rowid(db));
     return ruleId;
 }
 
 std::vector<std::tuple<int, int, std::string, double, int>> HistoricoRepositorySQLite::listarRegrasPorUsuario(int userId) {
-    std::lock_guard<std::mutex> lock(dbMutex);
+    auto conexao = leitores.adquirir();
     std::vector<std::tuple<int, int, std::string, double, int>> regras;
-    std::string query = "SELECT id, user_id, tipo, valor, extra FROM TB_REGRAS WHERE user_id = ?";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    sqlite3_stmt* stmt = conexao.stmts().obter("SELECT id, user_id, tipo, valor, extra FROM TB_REGRAS WHERE user_id = ?");
+    if (stmt) {
+        StmtReset reset(stmt);
         sqlite3_bind_int(stmt, 1, userId);
         while (sqlite3_step(stmt) == SQLITE_ROW) {
             int id = sqlite3_column_int(stmt, 0);
@@ -349,30 +709,147 @@ std::vector<std::tuple<int, int, std::string, double, int>> HistoricoRepositoryS
             int extra = sqlite3_column_int(stmt, 4);
             regras.emplace_back(id, uid, tipo, valor, extra);
         }
-        sqlite3_finalize(stmt);
     }
     return regras;
 }
 
 std::vector<Leitura> HistoricoRepositorySQLite::listarLeiturasPorUsuario(int userId, int limit) {
-    std::lock_guard<std::mutex> lock(dbMutex);
+    auto conexao = leitores.adquirir();
     std::vector<Leitura> leituras;
-    std::string query = "SELECT id, user_id, idSHA, data, valor, caminhoImagem FROM TB_LEITURAS WHERE user_id = ? ORDER BY id DESC LIMIT ?";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    sqlite3_stmt* stmt = conexao.stmts().obter("SELECT id, user_id, idSHA, data, valor, caminhoImagem FROM TB_LEITURAS WHERE user_id = ? ORDER BY id DESC LIMIT ?");
+    if (stmt) {
+        StmtReset reset(stmt);
         sqlite3_bind_int(stmt, 1, userId);
         sqlite3_bind_int(stmt, 2, limit);
         while (sqlite3_step(stmt) == SQLITE_ROW) {
-            Leitura leitura;
-            leitura.id = sqlite3_column_int(stmt, 0);
-            leitura.userId = sqlite3_column_int(stmt, 1);
-            leitura.idSHA = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-            leitura.data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-            leitura.valor = sqlite3_column_double(stmt, 4);
-            leitura.caminhoImagem = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
-            leituras.push_back(leitura);
+            leituras.push_back(lerLeitura(stmt));
         }
-        sqlite3_finalize(stmt);
     }
     return leituras;
 }
+
+// Cursor (data, id) a partir do qual a página começa (exclusivo): sem cursor, começa do topo
+static std::pair<int64_t, int64_t> cursorInicial(const FiltroHistorico& filtro) {
+    if (filtro.aposId > 0) return {filtro.aposData, filtro.aposId};
+    return {std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::max()};
+}
+
+static std::string_view colunaView(sqlite3_stmt* stmt, int col) {
+    const char* txt = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+    if (!txt) return {};
+    return std::string_view(txt, static_cast<size_t>(sqlite3_column_bytes(stmt, col)));
+}
+
+// Prepara e associa a consulta de leituras do filtro; o chamador faz o reset
+static sqlite3_stmt* prepararConsultaLeituras(StatementCache& cache, const FiltroHistorico& filtro) {
+    // Com idSHA usa IDX_LEITURAS_USER_SHA_DATA (user_id, idSHA, data, id); sem,
+    // IDX_LEITURAS_USER_DATA_ID: a busca já começa no fim do intervalo/cursor
+    sqlite3_stmt* stmt = filtro.idSHA
+        ? cache.obter("SELECT id, user_id, idSHA, data, valor, caminhoImagem FROM TB_LEITURAS "
+                      "WHERE user_id = ? AND idSHA = ? AND data >= ? AND data < ? AND (data, id) < (?, ?) "
+                      "ORDER BY data DESC, id DESC LIMIT ?")
+        : cache.obter("SELECT id, user_id, idSHA, data, valor, caminhoImagem FROM TB_LEITURAS "
+                      "WHERE user_id = ? AND data >= ? AND data < ? AND (data, id) < (?, ?) "
+                      "ORDER BY data DESC, id DESC LIMIT ?");
+    if (!stmt) return nullptr;
+    auto [aposData, aposId] = cursorInicial(filtro);
+    int idx = 1;
+    sqlite3_bind_int(stmt, idx++, filtro.userId);
+    if (filtro.idSHA) sqlite3_bind_text(stmt, idx++, filtro.idSHA->c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, idx++, filtro.inicio);
+    sqlite3_bind_int64(stmt, idx++, filtro.fim);
+    sqlite3_bind_int64(stmt, idx++, aposData);
+    sqlite3_bind_int64(stmt, idx++, aposId);
+    sqlite3_bind_int(stmt, idx++, filtro.limite > 0 ? filtro.limite : -1); // LIMIT -1 = sem limite
+    return stmt;
+}
+
+static sqlite3_stmt* prepararConsultaAlertas(StatementCache& cache, const FiltroHistorico& filtro) {
+    sqlite3_stmt* stmt = cache.obter("SELECT id, user_id, consumo, mensagem, data FROM TB_ALERTAS "
+                                     "WHERE user_id = ? AND data >= ? AND data < ? AND (data, id) < (?, ?) "
+                                     "ORDER BY data DESC, id DESC LIMIT ?");
+    if (!stmt) return nullptr;
+    auto [aposData, aposId] = cursorInicial(filtro);
+    sqlite3_bind_int(stmt, 1, filtro.userId);
+    sqlite3_bind_int64(stmt, 2, filtro.inicio);
+    sqlite3_bind_int64(stmt, 3, filtro.fim);
+    sqlite3_bind_int64(stmt, 4, aposData);
+    sqlite3_bind_int64(stmt, 5, aposId);
+    sqlite3_bind_int(stmt, 6, filtro.limite > 0 ? filtro.limite : -1);
+    return stmt;
+}
+
+Pagina<Leitura> HistoricoRepositorySQLite::listarLeiturasPaginado(const FiltroHistorico& filtro) {
+    auto conexao = leitores.adquirir();
+    Pagina<Leitura> pagina;
+    sqlite3_stmt* stmt = prepararConsultaLeituras(conexao.stmts(), filtro);
+    if (stmt) {
+        StmtReset reset(stmt);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            pagina.itens.push_back(lerLeitura(stmt));
+        }
+    }
+    if (filtro.limite > 0 && pagina.itens.size() == static_cast<size_t>(filtro.limite)) {
+        pagina.proximoData = pagina.itens.back().data;
+        pagina.proximoId = pagina.itens.back().id;
+    }
+    return pagina;
+}
+
+Pagina<AlertaRecord> HistoricoRepositorySQLite::listarAlertasPaginado(const FiltroHistorico& filtro) {
+    auto conexao = leitores.adquirir();
+    Pagina<AlertaRecord> pagina;
+    sqlite3_stmt* stmt = prepararConsultaAlertas(conexao.stmts(), filtro);
+    if (stmt) {
+        StmtReset reset(stmt);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            pagina.itens.push_back(lerAlerta(stmt));
+        }
+    }
+    if (filtro.limite > 0 && pagina.itens.size() == static_cast<size_t>(filtro.limite)) {
+        pagina.proximoData = pagina.itens.back().data;
+        pagina.proximoId = pagina.itens.back().id;
+    }
+    return pagina;
+}
+
+void HistoricoRepositorySQLite::percorrerLeituras(const FiltroHistorico& filtro, const VisitanteLeitura& visitante) {
+    auto conexao = leitores.adquirir();
+    sqlite3_stmt* stmt = prepararConsultaLeituras(conexao.stmts(), filtro);
+    if (!stmt) return;
+    StmtReset reset(stmt);
+    LeituraView linha;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        linha.id = sqlite3_column_int(stmt, 0);
+        linha.userId = sqlite3_column_int(stmt, 1);
+        linha.idSHA = colunaView(stmt, 2);
+        linha.data = sqlite3_column_int64(stmt, 3);
+        linha.valor = sqlite3_column_double(stmt, 4);
+        linha.caminhoImagem = colunaView(stmt, 5);
+        if (!visitante(linha)) break;
+    }
+}
+
+void HistoricoRepositorySQLite::percorrerAlertas(const FiltroHistorico& filtro, const VisitanteAlerta& visitante) {
+    auto conexao = leitores.adquirir();
+    sqlite3_stmt* stmt = prepararConsultaAlertas(conexao.stmts(), filtro);
+    if (!stmt) return;
+    StmtReset reset(stmt);
+    AlertaView linha;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        linha.id = sqlite3_column_int(stmt, 0);
+        linha.userId = sqlite3_column_int(stmt, 1);
+        linha.consumo = sqlite3_column_double(stmt, 2);
+        linha.mensagem = colunaView(stmt, 3);
+        linha.data = sqlite3_column_int64(stmt, 4);
+        if (!visitante(linha)) break;
+    }
+}
+
+StatementCache::Estatisticas HistoricoRepositorySQLite::estatisticasStatements() const {
+    auto total = leitores.estatisticas();
+    auto escrita = stmts.estatisticas();
+    total.prepares += escrita.prepares;
+    total.execucoes += escrita.execucoes;
+    return total;
+}
@@ -7,18 +7,107 @@
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <cstdint>
+#include <deque>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+
+// Cria/atualiza o schema até a versão mais recente (controlada por PRAGMA user_version)
+void aplicarMigracoes(sqlite3* db);
+
+// Cache de prepared statements: cada SQL é compilado uma única vez por conexão
+// e reaproveitado (reset + rebind) nas chamadas seguintes.
+class StatementCache {
+public:
+    struct Estatisticas {
+        uint64_t prepares = 0;   // chamadas a sqlite3_prepare_v2
+        uint64_t execucoes = 0;  // usos de statements (cacheados ou não)
+    };
+
+    void setConexao(sqlite3* conexao) { db = conexao; }
+    sqlite3_stmt* obter(const std::string& sql);
+    void finalizarTodos();
+    // Pode ser lida de outra thread enquanto a conexão está em uso
+    Estatisticas estatisticas() const { return {prepares.load(std::memory_order_relaxed), execucoes.load(std::memory_order_relaxed)}; }
 
-class UsuarioRepositorySQLite : public IUsuarioRepository {
 private:
     sqlite3* db = nullptr;
+    std::unordered_map<std::string, sqlite3_stmt*> stmts;
+    std::atomic<uint64_t> prepares{0};
+    std::atomic<uint64_t> execucoes{0};
+};
+
+// Devolve o statement ao estado inicial ao sair do escopo (libera locks de leitura)
+class StmtReset {
+    sqlite3_stmt* stmt;
+public:
+    explicit StmtReset(sqlite3_stmt* s) : stmt(s) {}
+    ~StmtReset() {
+        if (stmt) {
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        }
+    }
+    StmtReset(const StmtReset&) = delete;
+    StmtReset& operator=(const StmtReset&) = delete;
+};
+
+// Pool de conexões somente leitura. Com o banco em WAL, consultas rodam em
+// paralelo entre si e com o writer, sem disputar o dbMutex do repositório.
+class PoolLeitura {
+public:
+    struct Conexao {
+        sqlite3* db = nullptr;
+        StatementCache stmts;
+    };
+
+    // Empresta uma conexão e a devolve ao pool ao sair do escopo
+    class Handle {
+        PoolLeitura* pool;
+        Conexao* conexao;
+    public:
+        Handle(PoolLeitura* p, Conexao* c) : pool(p), conexao(c) {}
+        ~Handle() { pool->devolver(conexao); }
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+        StatementCache& stmts() { return conexao->stmts; }
+    };
+
+    ~PoolLeitura() { fechar(); }
+
+    void abrir(const std::string& path, size_t tamanho);
+    void fechar();
+    Handle adquirir();
+    StatementCache::Estatisticas estatisticas() const;
+
+private:
+    std::vector<std::unique_ptr<Conexao>> conexoes;
+    std::vector<Conexao*> livres;
+    mutable std::mutex poolMutex;
+    std::condition_variable livreCv;
+
+    void devolver(Conexao* c);
+};
+
+// Conexões de leitura por repositório quando o chamador não informa
+constexpr size_t CONEXOES_LEITURA_PADRAO = 4;
+
+class UsuarioRepositorySQLite : public IUsuarioRepository {
+private:
+    sqlite3* db = nullptr;           // conexão de escrita, protegida por dbMutex
     std::string dbPath;
     mutable std::mutex dbMutex;
+    StatementCache stmts;
+    PoolLeitura leitores;
 
     void initSchema();
-    std::optional<Usuario> carregarUsuarioComHidrometros(int id);
+    std::optional<Usuario> carregarUsuarioComHidrometros(StatementCache& cache, int id);
 
 public:
-    explicit UsuarioRepositorySQLite(const std::string& path);
+    explicit UsuarioRepositorySQLite(const std::string& path, size_t conexoesLeitura = CONEXOES_LEITURA_PADRAO);
     ~UsuarioRepositorySQLite();
 
     Usuario salvar(const Usuario& user) override;
@@ -28,26 +117,82 @@ public:
     void vincularHidrometro(int userId, const std::string& idSHA) override;
     void desvincularHidrometro(int userId, const std::string& idSHA) override;
     std::vector<Usuario> listarTodosUsuarios() override;
+
+    StatementCache::Estatisticas estatisticasStatements() const;
+};
+
+// Parâmetros do modo de ingestão assíncrona (group commit) de leituras
+struct ConfigEscritaAssincrona {
+    size_t capacidadeFila = 10000;                     // salvarLeitura bloqueia quando a fila enche
+    size_t tamanhoLote = 256;                          // leituras por transação
+    std::chrono::milliseconds intervaloFlush{200};     // tempo máximo de espera por um lote cheio
+};
+
+struct EstatisticasEscrita {
+    size_t pendentes = 0;           // leituras na fila aguardando commit
+    uint64_t gravadas = 0;          // leituras efetivamente gravadas pelo writer
+    uint64_t falhas = 0;            // leituras que nem sozinhas puderam ser gravadas (perdidas)
+    uint64_t lotes = 0;             // transações efetivadas
+    int64_t atrasoMaisAntigoMs = 0; // idade da leitura mais antiga ainda na fila
 };
 
 class HistoricoRepositorySQLite : public IHistoricoRepository {
 private:
-    sqlite3* db = nullptr;
+    sqlite3* db = nullptr;           // conexão de escrita, protegida por dbMutex
     std::string dbPath;
     mutable std::mutex dbMutex;
+    StatementCache stmts;
+    PoolLeitura leitores;
+
+    // Ingestão assíncrona: fila limitada + thread writer com commits em lote
+    struct LeituraPendente {
+        Leitura leitura;
+        std::chrono::steady_clock::time_point enfileiradaEm;
+    };
+    ConfigEscritaAssincrona cfgEscrita;
+    std::deque<LeituraPendente> filaLeituras;
+    mutable std::mutex filaMutex;
+    std::condition_variable filaCv;      // acorda o writer
+    std::condition_variable espacoCv;    // acorda produtores / flush
+    std::thread writer;
+    bool assincrono = false;
+    bool encerrando = false;
+    bool flushSolicitado = false;
+    uint64_t enfileiradas = 0;
+    uint64_t processadas = 0; // gravadas + falhas; é o que flush() espera alcançar
+    uint64_t gravadas = 0;
+    uint64_t falhas = 0;
+    uint64_t lotes = 0;
 
     void initSchema();
+    void inserirLeitura(const Leitura& leitura);
+    // Retorna quantas leituras do lote não puderam ser gravadas
+    size_t gravarLote(std::vector<LeituraPendente>& lote);
+    void loopWriter();
 
 public:
-    explicit HistoricoRepositorySQLite(const std::string& path);
+    explicit HistoricoRepositorySQLite(const std::string& path, size_t conexoesLeitura = CONEXOES_LEITURA_PADRAO);
     ~HistoricoRepositorySQLite();
 
+    // Liga o modo assíncrono (writer dedicado + commits em lote). salvarLeitura passa a só enfileirar.
+    void ativarEscritaAssincrona(const ConfigEscritaAssincrona& cfg = ConfigEscritaAssincrona{});
+    // Bloqueia até que todas as leituras enfileiradas até aqui estejam gravadas
+    void flush();
+    EstatisticasEscrita estatisticasEscrita() const;
+
     void salvarLeitura(const Leitura& leitura) override;
     void salvarAlerta(const AlertaRecord& alerta) override;
     std::vector<AlertaRecord> listarAlertasPorUsuario(int userId) override;
     int salvarRegra(int userId, const std::string& tipo, double valor, int extra = 0) override;
     std::vector<std::tuple<int, int, std::string, double, int>> listarRegrasPorUsuario(int userId) override;
     std::vector<Leitura> listarLeiturasPorUsuario(int userId, int limit = 10) override;
+    Pagina<Leitura> listarLeiturasPaginado(const FiltroHistorico& filtro) override;
+    Pagina<AlertaRecord> listarAlertasPaginado(const FiltroHistorico& filtro) override;
+    // Segura uma conexão do pool durante toda a varredura
+    void percorrerLeituras(const FiltroHistorico& filtro, const VisitanteLeitura& visitante) override;
+    void percorrerAlertas(const FiltroHistorico& filtro, const VisitanteAlerta& visitante) override;
+
+    StatementCache::Estatisticas estatisticasStatements() const;
 };
 
 #endif // SQLITE_REPOSITORY_H